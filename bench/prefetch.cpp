@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "splice-pool.hpp"
+
+// Compares plain, batched, and jump-indexed iteration over a Stack whose
+// nodes have been shuffled throughout the pool, so that each step of a plain
+// iteration is a dependent load which misses the cache.  The cost of building
+// a JumpIndex is reported separately from its scans, since it pays off over
+// scans repeated while the Stack is unchanged.
+//
+// Usage: splice-pool-bench [nodes]
+
+namespace
+{
+    struct Item
+    {
+        std::uint64_t key;
+        char pad[56];
+    };
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    template<typename F>
+    double nsPerNode(F f, std::size_t count)
+    {
+        double best(0);
+
+        for (std::size_t run(0); run < 5; ++run)
+        {
+            const auto start(Clock::now());
+            f();
+            const std::chrono::duration<double, std::nano> elapsed(
+                    Clock::now() - start);
+
+            const double ns(elapsed.count() / count);
+            if (!run || ns < best) best = ns;
+        }
+
+        return best;
+    }
+
+    void report(const std::string& name, double ns)
+    {
+        std::cout << std::setw(24) << std::left << name << std::fixed <<
+            std::setprecision(2) << ns << " ns/node" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t count(
+            argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 20);
+
+    splicer::ObjectPool<Item> pool(65536);
+    splicer::ObjectPool<Item>::UniqueStackType owned(pool.acquire(count));
+    splicer::Stack<Item> acquired(owned.release());
+
+    std::vector<splicer::Node<Item>*> nodes;
+    while (!acquired.empty()) nodes.push_back(acquired.pop());
+
+    std::mt19937 gen(42);
+    std::shuffle(nodes.begin(), nodes.end(), gen);
+
+    splicer::Stack<Item> stack;
+    for (std::size_t i(0); i < nodes.size(); ++i)
+    {
+        nodes[i]->val().key = i;
+        stack.pushBack(nodes[i]);
+    }
+
+    std::uint64_t sum(0);
+    const std::uint64_t expected(
+            static_cast<std::uint64_t>(count) * (count - 1) / 2);
+
+    auto check([&sum, expected]()
+    {
+        if (sum != expected)
+        {
+            std::cout << "Bad sum: " << sum << std::endl;
+            std::exit(1);
+        }
+        sum = 0;
+    });
+
+    std::cout << "Iterating " << count << " shuffled nodes" << std::endl;
+
+    report("plain", nsPerNode([&]()
+    {
+        for (const Item& item : stack) sum += item.key;
+        check();
+    }, count));
+
+    for (const std::size_t batch : { 8, 16, 64 })
+    {
+        report("forEachBatch(" + std::to_string(batch) + ")", nsPerNode([&]()
+        {
+            stack.forEachBatch([&sum](const Item& item)
+            {
+                sum += item.key;
+            }, batch);
+            check();
+        }, count));
+    }
+
+    // With some work per node, the walk of forEachBatch overlaps that work
+    // while a plain iteration stalls on each load before doing it.
+    std::uint64_t mixed(0);
+    auto work([&sum, &mixed](const Item& item)
+    {
+        std::uint64_t h(item.key);
+        for (int i(0); i < 32; ++i) h = h * 6364136223846793005ull + 1;
+        mixed ^= h;
+        sum += item.key;
+    });
+
+    report("plain + work", nsPerNode([&]()
+    {
+        for (const Item& item : stack) work(item);
+        check();
+    }, count));
+
+    report("forEachBatch + work", nsPerNode([&]()
+    {
+        stack.forEachBatch(work);
+        check();
+    }, count));
+
+    splicer::JumpIndex<const splicer::Node<Item>> index(
+            static_cast<const splicer::Stack<Item>&>(stack).jumpIndex());
+
+    report("jumpIndex build", nsPerNode([&]()
+    {
+        index = static_cast<const splicer::Stack<Item>&>(stack).jumpIndex();
+    }, count));
+
+    for (const std::size_t distance : { 0, 4, 16, 64 })
+    {
+        index = static_cast<const splicer::Stack<Item>&>(stack).jumpIndex(
+                distance);
+
+        report("jumpIndex(" + std::to_string(distance) + ")", nsPerNode([&]()
+        {
+            for (const Item& item : index) sum += item.key;
+            check();
+        }, count));
+    }
+
+    if (mixed == 42) std::cout << std::endl;
+
+    pool.release(std::move(stack));
+
+    return 0;
+}
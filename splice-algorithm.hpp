@@ -0,0 +1,333 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+namespace detail
+{
+
+// A tournament tree over the heads of k sorted stacks, whose internal nodes
+// hold the losers of each match, so that replacing the winner costs a
+// single comparison per level.  Ties go to the lower input index, which
+// keeps the merge stable.
+template<typename T, typename Compare>
+class LoserTree
+{
+public:
+    LoserTree(std::vector<Stack<T>>& stacks, Compare compare)
+        : m_compare(compare)
+        , m_heads(stacks.size())
+        , m_tree(stacks.size())
+    {
+        for (std::size_t i(0); i < stacks.size(); ++i)
+        {
+            m_heads[i] = stacks[i].head();
+        }
+
+        if (!m_heads.empty()) m_tree[0] = play(1);
+    }
+
+    // Pop the least node across every input, or null when all are drained.
+    Node<T>* pop()
+    {
+        if (m_heads.empty()) return nullptr;
+
+        std::size_t winner(m_tree[0]);
+        Node<T>* node(m_heads[winner]);
+        if (!node) return nullptr;
+
+        m_heads[winner] = node->next();
+
+        const std::size_t k(m_heads.size());
+        for (std::size_t p((winner + k) / 2); p > 0; p /= 2)
+        {
+            if (beats(m_tree[p], winner)) std::swap(m_tree[p], winner);
+        }
+
+        m_tree[0] = winner;
+        return node;
+    }
+
+private:
+    bool beats(std::size_t a, std::size_t b) const
+    {
+        const Node<T>* na(m_heads[a]);
+        const Node<T>* nb(m_heads[b]);
+
+        if (!na) return false;
+        if (!nb) return true;
+        if (m_compare(**na, **nb)) return true;
+        if (m_compare(**nb, **na)) return false;
+        return a < b;
+    }
+
+    // Returns the winner of the subtree at position p, recording losers.
+    // Leaves occupy positions k through 2k - 1.
+    std::size_t play(std::size_t p)
+    {
+        const std::size_t k(m_heads.size());
+        if (p >= k) return p - k;
+
+        const std::size_t a(play(p * 2));
+        const std::size_t b(play(p * 2 + 1));
+
+        if (beats(a, b))
+        {
+            m_tree[p] = b;
+            return a;
+        }
+
+        m_tree[p] = a;
+        return b;
+    }
+
+    Compare m_compare;
+    std::vector<Node<T>*> m_heads;
+    std::vector<std::size_t> m_tree;
+};
+
+// Merge pairs of adjacent stacks concurrently until one remains.  Since the
+// earlier stack of each pair absorbs the later, the result is stable.
+template<typename T, typename Compare>
+Stack<T> reduce(std::vector<Stack<T>>& runs, Compare compare)
+{
+    while (runs.size() > 1)
+    {
+        std::vector<std::thread> threads;
+
+        for (std::size_t i(0); i + 1 < runs.size(); i += 2)
+        {
+            threads.emplace_back([&runs, i, compare]()
+            {
+                runs[i].merge(runs[i + 1], compare);
+            });
+        }
+
+        for (auto& t : threads) t.join();
+
+        std::size_t out(1);
+        for (std::size_t i(2); i < runs.size(); i += 2)
+        {
+            runs[out++] = std::move(runs[i]);
+        }
+
+        runs.resize(out);
+    }
+
+    Stack<T> result;
+    if (!runs.empty()) result = std::move(runs.front());
+    return result;
+}
+
+} // namespace detail
+
+// Merge any number of sorted stacks into one sorted Stack, relinking their
+// nodes, and leaving each input empty.  The merge is stable: of nodes with
+// equal keys, those from earlier inputs come first.  A loser tree over the
+// input heads makes this O(n log k) for n nodes across k stacks.
+//
+// With more than one thread, the inputs are divided into that many groups
+// which are merged concurrently, and the results are combined by a parallel
+// tree reduction of pairwise merges.
+template<typename T, typename Compare>
+Stack<T> mergeAll(
+        std::vector<Stack<T>>& stacks,
+        Compare compare,
+        std::size_t threads = 1)
+{
+    if (threads > 1 && stacks.size() >= threads * 2)
+    {
+        std::vector<std::vector<Stack<T>>> groups(threads);
+        const std::size_t per((stacks.size() + threads - 1) / threads);
+
+        for (std::size_t i(0); i < stacks.size(); ++i)
+        {
+            groups[i / per].push_back(std::move(stacks[i]));
+        }
+
+        std::vector<Stack<T>> runs(threads);
+        std::vector<std::thread> workers;
+
+        for (std::size_t g(0); g < threads; ++g)
+        {
+            workers.emplace_back([&groups, &runs, g, compare]()
+            {
+                runs[g] = mergeAll(groups[g], compare);
+            });
+        }
+
+        for (auto& t : workers) t.join();
+
+        return detail::reduce(runs, compare);
+    }
+
+    Stack<T> result;
+    detail::LoserTree<T, Compare> tree(stacks, compare);
+
+    while (Node<T>* node = tree.pop()) result.pushBack(node);
+
+    for (auto& stack : stacks) stack = Stack<T>();
+
+    return result;
+}
+
+// As above, for UniqueStacks, which must all belong to the same pool.
+template<typename T, typename Compare>
+UniqueStack<T> mergeAll(
+        SplicePool<T>& pool,
+        std::vector<UniqueStack<T>>& stacks,
+        Compare compare,
+        std::size_t threads = 1)
+{
+    std::vector<Stack<T>> released;
+    released.reserve(stacks.size());
+
+    for (auto& stack : stacks)
+    {
+        assert(&stack.pool() == &pool);
+        released.push_back(stack.release());
+    }
+
+    return UniqueStack<T>(pool, mergeAll(released, compare, threads));
+}
+
+// Sort a stack across threads, by splitting it into equal runs with
+// popStack, sorting each run concurrently, and combining the sorted runs with
+// a parallel tree reduction of merges.  Only node links are rewritten, and
+// the sort is stable.  Stacks too small to benefit are sorted in place on
+// the calling thread.
+template<typename T, typename Compare>
+void parallelSort(
+        Stack<T>& stack,
+        Compare compare,
+        std::size_t threads = std::thread::hardware_concurrency())
+{
+    const std::size_t minRun(8192);
+
+    threads = std::min(threads, stack.size() / minRun);
+
+    if (threads < 2)
+    {
+        stack.sort(compare);
+        return;
+    }
+
+    const std::size_t per((stack.size() + threads - 1) / threads);
+
+    std::vector<Stack<T>> runs;
+    runs.reserve(threads);
+    while (!stack.empty()) runs.push_back(stack.popStack(per));
+
+    std::vector<std::thread> workers;
+    for (std::size_t i(1); i < runs.size(); ++i)
+    {
+        workers.emplace_back([&runs, i, compare]()
+        {
+            runs[i].sort(compare);
+        });
+    }
+
+    runs[0].sort(compare);
+    for (auto& t : workers) t.join();
+
+    stack = detail::reduce(runs, compare);
+}
+
+template<typename T, typename Compare>
+void parallelSort(
+        UniqueStack<T>& stack,
+        Compare compare,
+        std::size_t threads = std::thread::hardware_concurrency())
+{
+    Stack<T> sorting(stack.release());
+    parallelSort(sorting, compare, threads);
+    stack.reset(std::move(sorting));
+}
+
+// Sort a stack by an integral key, with a stable least-significant-digit
+// radix sort.  Each pass distributes the nodes by one byte of their keys
+// into 256 buckets with O(1) pushBack, and concatenates the buckets again.
+// Passes over bytes which are equal for every key are skipped, and nothing
+// is allocated.  Signed keys sort in their natural order.
+template<typename T, typename KeyFn>
+void radixSort(Stack<T>& stack, KeyFn key)
+{
+    using Key = typename std::decay<decltype(key(**stack.head()))>::type;
+    static_assert(std::is_integral<Key>::value, "Radix keys must be integral");
+
+    using Bits = typename std::make_unsigned<Key>::type;
+    const Bits flip(
+            std::is_signed<Key>::value ?
+                Bits(1) << (sizeof(Key) * 8 - 1) : 0);
+
+    if (stack.size() < 2) return;
+
+    // Find which bytes differ between any two keys.
+    Bits all(~Bits(0));
+    Bits any(0);
+
+    for (const T& v : stack)
+    {
+        const Bits k(static_cast<Bits>(key(v)) ^ flip);
+        all &= k;
+        any |= k;
+    }
+
+    const Bits varying(all ^ any);
+
+    Stack<T> buckets[256];
+
+    for (std::size_t shift(0); shift < sizeof(Key) * 8; shift += 8)
+    {
+        if (!((varying >> shift) & 0xff)) continue;
+
+        while (Node<T>* node = stack.pop())
+        {
+            const Bits k(static_cast<Bits>(key(**node)) ^ flip);
+            buckets[(k >> shift) & 0xff].pushBack(node);
+        }
+
+        for (Stack<T>& bucket : buckets) stack.pushBack(bucket);
+    }
+}
+
+template<typename T, typename KeyFn>
+void radixSort(UniqueStack<T>& stack, KeyFn key)
+{
+    Stack<T> sorting(stack.release());
+    radixSort(sorting, key);
+    stack.reset(std::move(sorting));
+}
+
+} // namespace splicer
@@ -0,0 +1,182 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// Raw storage for a single pooled allocation.  The constructor is
+// deliberately user-provided so that recycled slots are not zero-filled by
+// the pool on every release.
+template<std::size_t Size, std::size_t Align>
+struct AllocatorSlot
+{
+    AllocatorSlot() { }
+
+    typename std::aligned_storage<Size, Align>::type data;
+};
+
+// Per-thread cache of free slots for a given size class.  Allocations and
+// deallocations only touch the pool (and its mutex) once per batch.
+//
+// All types of the same size and alignment share a single pool, which lives
+// for the duration of the program.  Since the cache of each thread is
+// destroyed when that thread exits, containers using this allocator must not
+// outlive the threads that deallocate from them - in particular, they should
+// not have static storage duration.
+template<std::size_t Size, std::size_t Align>
+class AllocatorCache
+{
+public:
+    using Slot = AllocatorSlot<Size, Align>;
+
+    static_assert(
+            std::is_standard_layout<Node<Slot>>::value,
+            "Slot address must be the node address");
+
+    static ObjectPool<Slot>& pool()
+    {
+        // Intentionally leaked so that it outlives every thread cache.
+        static ObjectPool<Slot>* pool(new ObjectPool<Slot>(blockSize()));
+        return *pool;
+    }
+
+    static AllocatorCache& local()
+    {
+        thread_local AllocatorCache cache;
+        return cache;
+    }
+
+    ~AllocatorCache() { m_pool.release(std::move(m_stack)); }
+
+    void* allocate()
+    {
+        if (m_stack.empty()) m_stack = m_pool.acquire(batchSize()).release();
+        return &m_stack.pop()->val();
+    }
+
+    void deallocate(void* p)
+    {
+        m_stack.push(static_cast<Node<Slot>*>(p));
+
+        if (m_stack.size() >= batchSize() * 2)
+        {
+            m_pool.release(m_stack.popStack(batchSize()));
+        }
+    }
+
+    static std::size_t blockSize() { return 4096; }
+    static std::size_t batchSize() { return 64; }
+
+private:
+    AllocatorCache() : m_pool(pool()), m_stack() { }
+
+    AllocatorCache(const AllocatorCache&) = delete;
+    AllocatorCache& operator=(const AllocatorCache&) = delete;
+
+    ObjectPool<Slot>& m_pool;
+    Stack<Slot> m_stack;
+};
+
+// A stateless C++11 allocator suitable for node-based containers like
+// std::list, std::map, std::set, and std::unordered_map.  Single-object
+// allocations are served from a pool per size class through a thread-local
+// cache, and larger array allocations (e.g. hash buckets) go to the global
+// operator new.
+template<typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = PoolAllocator<U>;
+    };
+
+    using CacheType = AllocatorCache<sizeof(T), alignof(T)>;
+
+    static_assert(
+            alignof(T) <= alignof(std::max_align_t),
+            "Over-aligned types are not supported");
+
+    PoolAllocator() noexcept { }
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept { }
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 1) return static_cast<T*>(CacheType::local().allocate());
+        if (n > max_size()) throw std::bad_alloc();
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if (n == 1) CacheType::local().deallocate(p);
+        else ::operator delete(p);
+    }
+
+    std::size_t max_size() const noexcept
+    {
+        return std::numeric_limits<std::size_t>::max() / sizeof(T);
+    }
+
+    static ObjectPool<typename CacheType::Slot>& pool()
+    {
+        return CacheType::pool();
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept
+{
+    return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept
+{
+    return false;
+}
+
+} // namespace splicer
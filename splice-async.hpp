@@ -0,0 +1,722 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SPLICE_POOL_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// Asynchronous reads and writes on pooled buffers.  Ownership of each
+// buffer passes to the engine when a request is queued, and returns to the
+// caller, as a UniqueNode, with the completion of that request.
+template<typename T>
+class IoEngine
+{
+public:
+    using UniqueNodeType = UniqueNode<T*>;
+
+    struct Completion
+    {
+        Completion(UniqueNodeType&& buffer, int result, std::uint64_t tag)
+            : buffer(std::move(buffer))
+            , result(result)
+            , tag(tag)
+        { }
+
+        UniqueNodeType buffer;
+
+        // The number of bytes transferred, or a negated errno value.
+        int result;
+
+        // Caller-supplied identifier of the request.
+        std::uint64_t tag;
+    };
+
+    virtual ~IoEngine() { }
+
+    // Queue a request, which is not started until the next submit().
+    virtual void read(
+            int fd,
+            UniqueNodeType&& buffer,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag = 0) = 0;
+
+    virtual void write(
+            int fd,
+            UniqueNodeType&& buffer,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag = 0) = 0;
+
+    // Start every queued request as a single batch.  Returns the number of
+    // requests submitted.
+    virtual std::size_t submit() = 0;
+
+    // Wait for at least min completions, or for all outstanding requests if
+    // there are fewer than min, and return every available completion.
+    // Queued requests are submitted first.
+    virtual std::vector<Completion> wait(std::size_t min = 1) = 0;
+
+    // The number of requests which have been queued but not yet returned
+    // from wait().
+    virtual std::size_t outstanding() const = 0;
+};
+
+// Fallback engine which performs blocking pread/pwrite calls on a pool of
+// worker threads.
+template<typename T>
+class ThreadIoEngine : public IoEngine<T>
+{
+public:
+    using typename IoEngine<T>::UniqueNodeType;
+    using typename IoEngine<T>::Completion;
+
+    explicit ThreadIoEngine(BufferPool<T>& pool, std::size_t threads = 4)
+        : m_pool(pool)
+        , m_queued()
+        , m_work()
+        , m_done()
+        , m_outstanding(0)
+        , m_stop(false)
+        , m_mutex()
+        , m_workCv()
+        , m_doneCv()
+        , m_threads()
+    {
+        for (std::size_t i(0); i < std::max<std::size_t>(threads, 1); ++i)
+        {
+            m_threads.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~ThreadIoEngine()
+    {
+        wait(outstanding());
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_workCv.notify_all();
+        for (auto& t : m_threads) t.join();
+    }
+
+    virtual void read(
+            int fd,
+            UniqueNodeType&& buffer,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag = 0) override
+    {
+        queue(false, fd, buffer.release(), bytes, offset, tag);
+    }
+
+    virtual void write(
+            int fd,
+            UniqueNodeType&& buffer,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag = 0) override
+    {
+        queue(true, fd, buffer.release(), bytes, offset, tag);
+    }
+
+    virtual std::size_t submit() override
+    {
+        std::size_t count(0);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            count = m_queued.size();
+
+            m_work.insert(m_work.end(), m_queued.begin(), m_queued.end());
+            m_queued.clear();
+        }
+
+        m_workCv.notify_all();
+        return count;
+    }
+
+    virtual std::vector<Completion> wait(std::size_t min = 1) override
+    {
+        submit();
+
+        std::vector<Completion> result;
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        min = std::min(min, m_outstanding);
+        m_doneCv.wait(lock, [this, min]() { return m_done.size() >= min; });
+
+        for (const Request& r : m_done)
+        {
+            result.emplace_back(
+                    UniqueNodeType(m_pool, r.node),
+                    r.result,
+                    r.tag);
+        }
+
+        m_outstanding -= m_done.size();
+        m_done.clear();
+
+        return result;
+    }
+
+    virtual std::size_t outstanding() const override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_outstanding;
+    }
+
+private:
+    struct Request
+    {
+        bool write;
+        int fd;
+        Node<T*>* node;
+        std::size_t bytes;
+        off_t offset;
+        std::uint64_t tag;
+        int result;
+    };
+
+    void queue(
+            bool write,
+            int fd,
+            Node<T*>* node,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued.push_back(Request { write, fd, node, bytes, offset, tag, 0 });
+        ++m_outstanding;
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            m_workCv.wait(lock, [this]() { return m_stop || !m_work.empty(); });
+            if (m_work.empty()) return;
+
+            Request r(m_work.front());
+            m_work.pop_front();
+
+            lock.unlock();
+            perform(r);
+            lock.lock();
+
+            m_done.push_back(r);
+            m_doneCv.notify_all();
+        }
+    }
+
+    static void perform(Request& r)
+    {
+        char* data(reinterpret_cast<char*>(r.node->val()));
+        ssize_t n(0);
+
+        do
+        {
+            n = r.write ?
+                ::pwrite(r.fd, data, r.bytes, r.offset) :
+                ::pread(r.fd, data, r.bytes, r.offset);
+        }
+        while (n < 0 && errno == EINTR);
+
+        r.result = n < 0 ? -errno : n;
+    }
+
+    BufferPool<T>& m_pool;
+
+    std::vector<Request> m_queued;
+    std::deque<Request> m_work;
+    std::vector<Request> m_done;
+    std::size_t m_outstanding;
+    bool m_stop;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+    std::vector<std::thread> m_threads;
+};
+
+#if defined(SPLICE_POOL_IO_URING)
+
+// An io_uring engine, using raw system calls rather than liburing.  The
+// blocks of the pool which exist at construction are registered with the
+// kernel, so requests on their buffers use READ_FIXED/WRITE_FIXED and skip
+// the per-request page pinning.  Requests on buffers from blocks allocated
+// later still work, using READV/WRITEV, until refresh() registers those
+// blocks as well.
+//
+// Throws std::system_error if io_uring is unavailable.  An engine must be
+// used by only one thread at a time.
+template<typename T>
+class UringIoEngine : public IoEngine<T>
+{
+public:
+    using typename IoEngine<T>::UniqueNodeType;
+    using typename IoEngine<T>::Completion;
+
+    explicit UringIoEngine(BufferPool<T>& pool, unsigned entries = 256)
+        : m_pool(pool)
+        , m_fd(-1)
+        , m_sqRing(nullptr)
+        , m_cqRing(nullptr)
+        , m_sqRingSize(0)
+        , m_cqRingSize(0)
+        , m_sqes(nullptr)
+        , m_sqesSize(0)
+        , m_params()
+        , m_registered()
+        , m_slots()
+        , m_free()
+        , m_ready()
+        , m_queued(0)
+    {
+        std::memset(&m_params, 0, sizeof(m_params));
+
+        m_fd = ::syscall(__NR_io_uring_setup, entries, &m_params);
+        if (m_fd < 0) fail("io_uring_setup");
+
+        try
+        {
+            map();
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+
+        m_slots.resize(m_params.cq_entries);
+        for (unsigned i(0); i < m_params.cq_entries; ++i) m_free.push_back(i);
+
+        registerBuffers();
+    }
+
+    // Waits for requests in flight, whose buffers the kernel may still be
+    // using.  Should the ring fail while waiting, the buffers of any requests
+    // still in flight are abandoned rather than returned to the pool.
+    ~UringIoEngine()
+    {
+        try
+        {
+            while (outstanding() > m_ready.size()) reap(true);
+        }
+        catch (...) { }
+
+        m_ready.clear();
+        unregisterBuffers();
+        unmap();
+    }
+
+    virtual void read(
+            int fd,
+            UniqueNodeType&& buffer,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag = 0) override
+    {
+        queue(false, fd, buffer.release(), bytes, offset, tag);
+    }
+
+    virtual void write(
+            int fd,
+            UniqueNodeType&& buffer,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag = 0) override
+    {
+        queue(true, fd, buffer.release(), bytes, offset, tag);
+    }
+
+    virtual std::size_t submit() override
+    {
+        return enter(0);
+    }
+
+    virtual std::vector<Completion> wait(std::size_t min = 1) override
+    {
+        submit();
+        min = std::min(min, outstanding());
+
+        while (m_ready.size() < min) reap(true);
+        reap(false);
+
+        std::vector<Completion> result;
+        result.swap(m_ready);
+        return result;
+    }
+
+    virtual std::size_t outstanding() const override
+    {
+        return m_slots.size() - m_free.size() + m_ready.size();
+    }
+
+    // True if requests on this buffer use the registered, fixed buffers.
+    bool fixed(const T* buffer) const { return index(buffer) >= 0; }
+
+    // Register every block of the pool, including those allocated since the
+    // last registration, in place of the blocks registered before.  The
+    // registration is not changed under requests in flight, so if any are
+    // outstanding, this does nothing and returns false.
+    bool refresh()
+    {
+        if (outstanding()) return false;
+
+        unregisterBuffers();
+        registerBuffers();
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : node(nullptr), tag(0), iov() { }
+
+        Node<T*>* node;
+        std::uint64_t tag;
+        iovec iov;
+    };
+
+    static void fail(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    void map()
+    {
+        const io_sqring_offsets& sq(m_params.sq_off);
+        const io_cqring_offsets& cq(m_params.cq_off);
+
+        m_sqRingSize = sq.array + m_params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = cq.cqes + m_params.cq_entries * sizeof(io_uring_cqe);
+
+        const bool single(m_params.features & IORING_FEAT_SINGLE_MMAP);
+        if (single) m_sqRingSize = m_cqRingSize =
+            std::max(m_sqRingSize, m_cqRingSize);
+
+        m_sqRing = mmapRing(m_sqRingSize, IORING_OFF_SQ_RING);
+        m_cqRing = single ?
+            m_sqRing : mmapRing(m_cqRingSize, IORING_OFF_CQ_RING);
+
+        m_sqesSize = m_params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(
+                mmapRing(m_sqesSize, IORING_OFF_SQES));
+    }
+
+    void* mmapRing(std::size_t size, off_t offset)
+    {
+        void* p(
+                ::mmap(
+                    nullptr,
+                    size,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    m_fd,
+                    offset));
+
+        if (p == MAP_FAILED) fail("io_uring mmap");
+        return p;
+    }
+
+    void unmap()
+    {
+        if (m_sqes) ::munmap(m_sqes, m_sqesSize);
+        if (m_cqRing && m_cqRing != m_sqRing) ::munmap(m_cqRing, m_cqRingSize);
+        if (m_sqRing) ::munmap(m_sqRing, m_sqRingSize);
+        if (m_fd >= 0) ::close(m_fd);
+    }
+
+    // Register each block of the pool as a single fixed buffer.  If this
+    // fails, for example due to RLIMIT_MEMLOCK, requests proceed without
+    // fixed buffers.
+    void registerBuffers()
+    {
+        const std::vector<std::pair<T*, std::size_t>> blocks(m_pool.blocks());
+        if (blocks.empty()) return;
+
+        std::vector<iovec> iovs;
+
+        for (const auto& block : blocks)
+        {
+            iovec iov;
+            iov.iov_base = block.first;
+            iov.iov_len = block.second * sizeof(T);
+            iovs.push_back(iov);
+        }
+
+        if (!::syscall(
+                    __NR_io_uring_register,
+                    m_fd,
+                    IORING_REGISTER_BUFFERS,
+                    iovs.data(),
+                    iovs.size()))
+        {
+            m_registered = blocks;
+        }
+    }
+
+    void unregisterBuffers()
+    {
+        if (m_registered.empty()) return;
+
+        ::syscall(
+                __NR_io_uring_register,
+                m_fd,
+                IORING_UNREGISTER_BUFFERS,
+                nullptr,
+                0);
+
+        m_registered.clear();
+    }
+
+    // Index of the registered block containing this buffer, or -1.
+    int index(const T* buffer) const
+    {
+        auto it(
+                std::upper_bound(
+                    m_registered.begin(),
+                    m_registered.end(),
+                    buffer,
+                    [](const T* b, const std::pair<T*, std::size_t>& block)
+                    {
+                        return std::less<const T*>()(b, block.first);
+                    }));
+
+        if (it == m_registered.begin()) return -1;
+        --it;
+
+        if (!std::less<const T*>()(buffer, it->first + it->second)) return -1;
+        return it - m_registered.begin();
+    }
+
+    unsigned* sq(unsigned offset) const
+    {
+        return reinterpret_cast<unsigned*>(
+                static_cast<char*>(m_sqRing) + offset);
+    }
+
+    unsigned* cq(unsigned offset) const
+    {
+        return reinterpret_cast<unsigned*>(
+                static_cast<char*>(m_cqRing) + offset);
+    }
+
+    void queue(
+            bool write,
+            int fd,
+            Node<T*>* node,
+            std::size_t bytes,
+            off_t offset,
+            std::uint64_t tag)
+    {
+        // Every request needs a slot, of which there are as many as there
+        // are completion queue entries, so the completion queue can't
+        // overflow.
+        while (m_free.empty())
+        {
+            submit();
+            reap(true);
+        }
+
+        unsigned* head(sq(m_params.sq_off.head));
+        unsigned* tail(sq(m_params.sq_off.tail));
+        const unsigned mask(*sq(m_params.sq_off.ring_mask));
+
+        if (*tail - __atomic_load_n(head, __ATOMIC_ACQUIRE) ==
+                m_params.sq_entries)
+        {
+            submit();
+        }
+
+        const unsigned slotIndex(m_free.back());
+        m_free.pop_back();
+
+        Slot& slot(m_slots[slotIndex]);
+        slot.node = node;
+        slot.tag = tag;
+        slot.iov.iov_base = node->val();
+        slot.iov.iov_len = bytes;
+
+        const unsigned sqIndex(*tail & mask);
+        io_uring_sqe& sqe(m_sqes[sqIndex]);
+        std::memset(&sqe, 0, sizeof(sqe));
+
+        const int buf(index(node->val()));
+
+        if (buf >= 0)
+        {
+            sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe.addr = reinterpret_cast<std::uint64_t>(node->val());
+            sqe.len = bytes;
+            sqe.buf_index = buf;
+        }
+        else
+        {
+            sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe.addr = reinterpret_cast<std::uint64_t>(&slot.iov);
+            sqe.len = 1;
+        }
+
+        sqe.fd = fd;
+        sqe.off = offset;
+        sqe.user_data = slotIndex;
+
+        sq(m_params.sq_off.array)[sqIndex] = sqIndex;
+        __atomic_store_n(tail, *tail + 1, __ATOMIC_RELEASE);
+
+        ++m_queued;
+    }
+
+    std::size_t enter(unsigned minComplete)
+    {
+        const unsigned flags(minComplete ? IORING_ENTER_GETEVENTS : 0);
+        int result(0);
+
+        do
+        {
+            result = ::syscall(
+                    __NR_io_uring_enter,
+                    m_fd,
+                    m_queued,
+                    minComplete,
+                    flags,
+                    nullptr,
+                    0);
+        }
+        while (result < 0 && errno == EINTR);
+
+        if (result < 0) fail("io_uring_enter");
+
+        m_queued -= result;
+        return result;
+    }
+
+    // Move completions from the completion queue to m_ready, blocking for
+    // at least one if block is set.
+    void reap(bool block)
+    {
+        unsigned* head(cq(m_params.cq_off.head));
+        unsigned* tail(cq(m_params.cq_off.tail));
+        const unsigned mask(*cq(m_params.cq_off.ring_mask));
+        io_uring_cqe* cqes(
+                reinterpret_cast<io_uring_cqe*>(
+                    static_cast<char*>(m_cqRing) + m_params.cq_off.cqes));
+
+        if (block && *head == __atomic_load_n(tail, __ATOMIC_ACQUIRE))
+        {
+            enter(1);
+        }
+
+        unsigned current(*head);
+
+        while (current != __atomic_load_n(tail, __ATOMIC_ACQUIRE))
+        {
+            const io_uring_cqe& cqe(cqes[current & mask]);
+            Slot& slot(m_slots[cqe.user_data]);
+
+            m_ready.emplace_back(
+                    UniqueNodeType(m_pool, slot.node),
+                    cqe.res,
+                    slot.tag);
+
+            m_free.push_back(cqe.user_data);
+            slot = Slot();
+            ++current;
+        }
+
+        __atomic_store_n(head, current, __ATOMIC_RELEASE);
+    }
+
+    BufferPool<T>& m_pool;
+    int m_fd;
+
+    void* m_sqRing;
+    void* m_cqRing;
+    std::size_t m_sqRingSize;
+    std::size_t m_cqRingSize;
+    io_uring_sqe* m_sqes;
+    std::size_t m_sqesSize;
+    io_uring_params m_params;
+
+    std::vector<std::pair<T*, std::size_t>> m_registered;
+    std::vector<Slot> m_slots;
+    std::vector<unsigned> m_free;
+    std::vector<Completion> m_ready;
+    unsigned m_queued;
+};
+
+#endif
+
+// Create an io_uring engine if the platform and kernel support it, and a
+// thread pool engine otherwise.
+template<typename T>
+std::unique_ptr<IoEngine<T>> makeIoEngine(
+        BufferPool<T>& pool,
+        unsigned entries = 256,
+        std::size_t threads = 4)
+{
+#if defined(SPLICE_POOL_IO_URING)
+    try
+    {
+        return std::unique_ptr<IoEngine<T>>(
+                new UringIoEngine<T>(pool, entries));
+    }
+    catch (const std::system_error&) { }
+#endif
+
+    return std::unique_ptr<IoEngine<T>>(new ThreadIoEngine<T>(pool, threads));
+}
+
+} // namespace splicer
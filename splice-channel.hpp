@@ -0,0 +1,183 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// A channel which moves whole stacks of pooled nodes between threads.  Each
+// send splices a stack onto the back of the channel, and each receive
+// splices up to a given count from its front, so synchronization is paid
+// per batch rather than per node.  Nodes are received in the order in which
+// they were sent.
+//
+// Once closed, sends are rejected, while receives drain any nodes that
+// remain and then return empty stacks rather than blocking.
+template<typename T>
+class StackChannel
+{
+public:
+    using UniqueNodeType = UniqueNode<T>;
+    using UniqueStackType = UniqueStack<T>;
+
+    static std::size_t all() { return std::numeric_limits<std::size_t>::max(); }
+
+    explicit StackChannel(SplicePool<T>& pool)
+        : m_pool(pool)
+        , m_stack()
+        , m_closed(false)
+        , m_mutex()
+        , m_cv()
+    { }
+
+    ~StackChannel() { m_pool.release(std::move(m_stack)); }
+
+    // Returns false, leaving the stack with the caller, if the channel is
+    // closed.  The stack must belong to the pool of this channel.
+    bool send(UniqueStackType&& stack)
+    {
+        assert(&stack.pool() == &m_pool);
+        if (stack.empty()) return !closed();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_closed) return false;
+
+            Stack<T> sending(stack.release());
+            m_stack.pushBack(sending);
+        }
+
+        m_cv.notify_one();
+        return true;
+    }
+
+    // As above, leaving the node with the caller if the channel is closed.
+    bool send(UniqueNodeType&& node)
+    {
+        if (node.empty()) return !closed();
+
+        UniqueStackType stack(std::move(node));
+        if (send(std::move(stack))) return true;
+
+        node = stack.popOne();
+        return false;
+    }
+
+    // Block until nodes are available or the channel is closed.  An empty
+    // result means the channel is closed and drained.
+    UniqueStackType receive(std::size_t max = all())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return ready(); });
+        return take(lock, max);
+    }
+
+    // As receive(), but give up after a timeout, returning an empty stack.
+    template<typename Rep, typename Period>
+    UniqueStackType receiveFor(
+            const std::chrono::duration<Rep, Period>& timeout,
+            std::size_t max = all())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait_for(lock, timeout, [this]() { return ready(); });
+        return take(lock, max);
+    }
+
+    template<typename Clock, typename Duration>
+    UniqueStackType receiveUntil(
+            const std::chrono::time_point<Clock, Duration>& deadline,
+            std::size_t max = all())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait_until(lock, deadline, [this]() { return ready(); });
+        return take(lock, max);
+    }
+
+    // Never blocks.
+    UniqueStackType tryReceive(std::size_t max = all())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return take(lock, max);
+    }
+
+    // Wake every waiting receiver.  Nodes already sent remain receivable.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+
+        m_cv.notify_all();
+    }
+
+    bool closed() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stack.size();
+    }
+
+    SplicePool<T>& pool() { return m_pool; }
+
+private:
+    StackChannel(const StackChannel&) = delete;
+    StackChannel& operator=(const StackChannel&) = delete;
+
+    bool ready() const { return !m_stack.empty() || m_closed; }
+
+    UniqueStackType take(std::unique_lock<std::mutex>& lock, std::size_t max)
+    {
+        UniqueStackType result(m_pool, m_stack.popStack(max));
+        const bool more(!m_stack.empty());
+
+        lock.unlock();
+
+        // Since each send wakes only one receiver, pass the remainder on.
+        if (more && result.size()) m_cv.notify_one();
+
+        return result;
+    }
+
+    SplicePool<T>& m_pool;
+    Stack<T> m_stack;
+    bool m_closed;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
+
+} // namespace splicer
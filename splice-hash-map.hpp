@@ -0,0 +1,416 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// A chained hash map whose entries are nodes of an ObjectPool.  Each bucket
+// is a Stack, so that clear() splices every chain into a single Stack and
+// releases it to the pool at once, and reserve() acquires all of the nodes
+// it needs in one call.
+//
+// Alongside the buckets is an array of one metadata byte per bucket, which
+// holds a small Bloom filter of the hashes chained there.  Most lookups of
+// absent keys are answered from these bytes alone, without touching the
+// bucket or its nodes.
+//
+// Pointers to entries remain valid until they are erased, including across
+// rehashing.
+template<
+    typename K,
+    typename V,
+    typename Hash = std::hash<K>,
+    typename Equal = std::equal_to<K>>
+class HashMap
+{
+public:
+    using Entry = std::pair<const K, V>;
+    using Pool = ObjectPool<Entry>;
+
+    explicit HashMap(
+            Pool& pool,
+            std::size_t buckets = 16,
+            const Hash& hash = Hash(),
+            const Equal& equal = Equal())
+        : m_pool(pool)
+        , m_hash(hash)
+        , m_equal(equal)
+        , m_buckets()
+        , m_tags()
+        , m_shift(0)
+        , m_size(0)
+        , m_spare()
+    {
+        resize(buckets);
+    }
+
+    ~HashMap()
+    {
+        clear();
+        m_pool.release(std::move(m_spare));
+    }
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return !m_size; }
+    std::size_t bucketCount() const { return m_buckets.size(); }
+
+    // Make room for count entries without rehashing, and acquire the nodes
+    // for them from the pool in bulk.
+    void reserve(std::size_t count)
+    {
+        if (count > m_buckets.size()) rehash(count);
+
+        const std::size_t have(m_size + m_spare.size());
+        if (count > have)
+        {
+            Stack<Entry> acquired(m_pool.acquire(count - have).release());
+            m_spare.push(acquired);
+        }
+    }
+
+    // Returns the entry for this key, and whether it was inserted.  If the
+    // key already exists, the value is not modified.
+    template<typename... Args>
+    std::pair<Entry*, bool> emplace(const K& key, Args&&... args)
+    {
+        const std::uint64_t h(mix(m_hash(key)));
+        const std::size_t b(bucket(h));
+
+        if (Node<Entry>* node = find(key, h, b)) return { &node->val(), false };
+
+        if (m_size >= m_buckets.size())
+        {
+            rehash(m_buckets.size() * 2);
+            return emplace(key, std::forward<Args>(args)...);
+        }
+
+        Node<Entry>* node(acquire(key, std::forward<Args>(args)...));
+        m_buckets[b].push(node);
+        m_tags[b] |= tag(h);
+        ++m_size;
+
+        return { &node->val(), true };
+    }
+
+    std::pair<Entry*, bool> insert(const K& key, const V& value)
+    {
+        return emplace(key, value);
+    }
+
+    V& operator[](const K& key) { return emplace(key).first->second; }
+
+    V* find(const K& key)
+    {
+        Entry* entry(findEntry(key));
+        return entry ? &entry->second : nullptr;
+    }
+
+    const V* find(const K& key) const
+    {
+        return const_cast<HashMap*>(this)->find(key);
+    }
+
+    Entry* findEntry(const K& key)
+    {
+        const std::uint64_t h(mix(m_hash(key)));
+        Node<Entry>* node(find(key, h, bucket(h)));
+        return node ? &node->val() : nullptr;
+    }
+
+    bool contains(const K& key) const { return find(key) != nullptr; }
+
+    bool erase(const K& key)
+    {
+        Node<Entry>* node(detach(key));
+        if (!node) return false;
+
+        m_pool.release(node);
+        return true;
+    }
+
+    // Reuse the node of the entry for one key as the entry for another,
+    // destroying the old entry and constructing the new one in place, so that
+    // nothing is released to the pool or acquired from it.  Returns the new
+    // entry, or null if there was no entry for the old key.
+    //
+    // Preconditions: there is no entry for the new key.
+    template<typename... Args>
+    Entry* replace(const K& oldKey, const K& key, Args&&... args)
+    {
+        Node<Entry>* node(detach(oldKey));
+        if (!node) return nullptr;
+
+        node->val().~Entry();
+
+        try
+        {
+            node->construct(
+                    std::piecewise_construct,
+                    std::forward_as_tuple(key),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        catch (...)
+        {
+            node->construct();
+            m_pool.release(node);
+            throw;
+        }
+
+        const std::uint64_t h(mix(m_hash(key)));
+        const std::size_t b(bucket(h));
+
+        m_buckets[b].push(node);
+        m_tags[b] |= tag(h);
+        ++m_size;
+
+        return &node->val();
+    }
+
+    // Erase every entry for which f returns true, releasing them all to the
+    // pool as a single Stack.  Returns the number erased.
+    template<typename F>
+    std::size_t eraseIf(F f)
+    {
+        Stack<Entry> erased;
+
+        for (std::size_t b(0); b < m_buckets.size(); ++b)
+        {
+            if (!m_tags[b]) continue;
+
+            Stack<Entry>& chain(m_buckets[b]);
+            Node<Entry>* before(nullptr);
+            Node<Entry>* node(chain.head());
+            std::uint8_t tags(0);
+
+            while (node)
+            {
+                Node<Entry>* next(node->next());
+
+                if (f(node->val()))
+                {
+                    erased.push(chain.popAfter(before));
+                }
+                else
+                {
+                    tags |= tag(mix(m_hash(node->val().first)));
+                    before = node;
+                }
+
+                node = next;
+            }
+
+            m_tags[b] = tags;
+        }
+
+        const std::size_t count(erased.size());
+        m_size -= count;
+        m_pool.release(std::move(erased));
+
+        return count;
+    }
+
+    // Splice every entry into one Stack and release it to the pool at once.
+    void clear()
+    {
+        if (!m_size) return;
+
+        Stack<Entry> all;
+
+        for (std::size_t b(0); b < m_buckets.size(); ++b)
+        {
+            if (m_tags[b])
+            {
+                all.push(m_buckets[b]);
+                m_tags[b] = 0;
+            }
+        }
+
+        m_pool.release(std::move(all));
+        m_size = 0;
+    }
+
+    template<typename F>
+    void forEach(F f)
+    {
+        for (std::size_t b(0); b < m_buckets.size(); ++b)
+        {
+            if (!m_tags[b]) continue;
+            for (Entry& entry : m_buckets[b]) f(entry);
+        }
+    }
+
+    template<typename F>
+    void forEach(F f) const
+    {
+        for (std::size_t b(0); b < m_buckets.size(); ++b)
+        {
+            if (!m_tags[b]) continue;
+            for (const Entry& entry : m_buckets[b]) f(entry);
+        }
+    }
+
+private:
+    HashMap(const HashMap&) = delete;
+    HashMap& operator=(const HashMap&) = delete;
+
+    // Fibonacci hashing, so that weak hashes like the identity hash of
+    // integers spread over both the bucket and the tag bits.
+    static std::uint64_t mix(std::size_t h)
+    {
+        return static_cast<std::uint64_t>(h) * 0x9e3779b97f4a7c15ull;
+    }
+
+    static std::uint8_t tag(std::uint64_t h)
+    {
+        return 1u << ((h >> 8) & 7);
+    }
+
+    std::size_t bucket(std::uint64_t h) const
+    {
+        return m_shift < 64 ? h >> m_shift : 0;
+    }
+
+    Node<Entry>* find(const K& key, std::uint64_t h, std::size_t b)
+    {
+        if (!(m_tags[b] & tag(h))) return nullptr;
+
+        for (Node<Entry>* node(m_buckets[b].head()); node; node = node->next())
+        {
+            if (m_equal(node->val().first, key)) return node;
+        }
+
+        return nullptr;
+    }
+
+    // Unlink the node of the entry for this key, if there is one, and rebuild
+    // the filter of its bucket from what remains.
+    Node<Entry>* detach(const K& key)
+    {
+        const std::uint64_t h(mix(m_hash(key)));
+        const std::size_t b(bucket(h));
+
+        if (!(m_tags[b] & tag(h))) return nullptr;
+
+        Stack<Entry>& chain(m_buckets[b]);
+        Node<Entry>* before(nullptr);
+        Node<Entry>* node(chain.head());
+
+        while (node && !m_equal(node->val().first, key))
+        {
+            before = node;
+            node = node->next();
+        }
+
+        if (!node) return nullptr;
+
+        chain.popAfter(before);
+        --m_size;
+
+        m_tags[b] = 0;
+        for (const Entry& entry : chain)
+        {
+            m_tags[b] |= tag(mix(m_hash(entry.first)));
+        }
+
+        return node;
+    }
+
+    template<typename... Args>
+    Node<Entry>* acquire(const K& key, Args&&... args)
+    {
+        if (Node<Entry>* node = m_spare.pop())
+        {
+            node->construct(
+                    std::piecewise_construct,
+                    std::forward_as_tuple(key),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+            return node;
+        }
+
+        return m_pool.acquireOne(
+                std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...)).release();
+    }
+
+    void resize(std::size_t count)
+    {
+        std::size_t size(1);
+        std::size_t bits(0);
+
+        while (size < count)
+        {
+            size *= 2;
+            ++bits;
+        }
+
+        m_buckets.assign(size, Stack<Entry>());
+        m_tags.assign(size, 0);
+        m_shift = 64 - bits;
+    }
+
+    // Relink every node into a larger bucket array.  No nodes are acquired
+    // or released.
+    void rehash(std::size_t count)
+    {
+        std::vector<Stack<Entry>> previous;
+        previous.swap(m_buckets);
+
+        resize(count);
+
+        for (Stack<Entry>& chain : previous)
+        {
+            while (Node<Entry>* node = chain.pop())
+            {
+                const std::uint64_t h(mix(m_hash(node->val().first)));
+                const std::size_t b(bucket(h));
+
+                m_buckets[b].push(node);
+                m_tags[b] |= tag(h);
+            }
+        }
+    }
+
+    Pool& m_pool;
+    Hash m_hash;
+    Equal m_equal;
+
+    std::vector<Stack<Entry>> m_buckets;
+    std::vector<std::uint8_t> m_tags;
+    std::size_t m_shift;
+    std::size_t m_size;
+
+    // Nodes acquired by reserve() and not yet used.
+    Stack<Entry> m_spare;
+};
+
+} // namespace splicer
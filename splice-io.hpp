@@ -0,0 +1,414 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// A file opened for direct I/O, which bypasses the page cache where the
+// platform and filesystem allow it, and otherwise falls back to buffered
+// I/O.  Direct I/O requires buffers, offsets, and lengths to be aligned to
+// the logical block size of the device, so use a BufferPool whose alignment
+// and buffer size are multiples of that block size.
+class DirectFile
+{
+public:
+    explicit DirectFile(
+            const std::string& path,
+            int flags = O_RDONLY,
+            mode_t mode = 0644)
+        : m_fd(-1)
+        , m_direct(false)
+    {
+#if defined(O_DIRECT)
+        m_fd = ::open(path.c_str(), flags | O_DIRECT, mode);
+
+        if (m_fd >= 0) m_direct = true;
+        else if (errno != EINVAL) fail("Could not open " + path);
+#endif
+
+        if (m_fd < 0)
+        {
+            m_fd = ::open(path.c_str(), flags, mode);
+            if (m_fd < 0) fail("Could not open " + path);
+
+#if defined(F_NOCACHE)
+            m_direct = ::fcntl(m_fd, F_NOCACHE, 1) == 0;
+#endif
+        }
+    }
+
+    ~DirectFile() { ::close(m_fd); }
+
+    int fd() const { return m_fd; }
+
+    // False if the page cache could not be bypassed for this file.
+    bool direct() const { return m_direct; }
+
+    // Returns the number of bytes read, which is less than the number of
+    // bytes requested only at the end of the file.
+    std::size_t read(void* dst, std::size_t bytes, off_t offset) const
+    {
+        char* pos(static_cast<char*>(dst));
+        std::size_t done(0);
+
+        while (done < bytes)
+        {
+            const ssize_t n(::pread(m_fd, pos + done, bytes - done, offset));
+
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                fail("Could not read");
+            }
+
+            if (!n) break;
+
+            done += n;
+            offset += n;
+        }
+
+        return done;
+    }
+
+    void write(const void* src, std::size_t bytes, off_t offset) const
+    {
+        const char* pos(static_cast<const char*>(src));
+        std::size_t done(0);
+
+        while (done < bytes)
+        {
+            const ssize_t n(::pwrite(m_fd, pos + done, bytes - done, offset));
+
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                fail("Could not write");
+            }
+
+            done += n;
+            offset += n;
+        }
+    }
+
+    // Fill each buffer of a Stack or UniqueStack, in order, from consecutive
+    // regions of the file beginning at offset.  Returns the total number of
+    // bytes read, which is short only if the end of the file was reached.
+    //
+    // These are named apart from read and write, whose raw pointer
+    // overloads a template taking any Buffers would otherwise hijack.
+    template<typename Buffers>
+    std::size_t readStack(
+            Buffers& buffers,
+            std::size_t bufferBytes,
+            off_t offset) const
+    {
+        std::size_t total(0);
+
+        for (auto buffer : buffers)
+        {
+            void* dst(buffer);
+            const std::size_t n(read(dst, bufferBytes, offset + total));
+            total += n;
+            if (n < bufferBytes) break;
+        }
+
+        return total;
+    }
+
+    // Write each buffer of a Stack or UniqueStack, in order, to consecutive
+    // regions of the file beginning at offset.
+    template<typename Buffers>
+    void writeStack(
+            const Buffers& buffers,
+            std::size_t bufferBytes,
+            off_t offset) const
+    {
+        for (const auto buffer : buffers)
+        {
+            write(static_cast<const void*>(buffer), bufferBytes, offset);
+            offset += bufferBytes;
+        }
+    }
+
+    // Direct writes must be a multiple of the block size, so use this to
+    // trim the padding of the final block.
+    void truncate(off_t size) const
+    {
+        if (::ftruncate(m_fd, size)) fail("Could not truncate");
+    }
+
+private:
+    DirectFile(const DirectFile&) = delete;
+    DirectFile& operator=(const DirectFile&) = delete;
+
+    static void fail(const std::string& message)
+    {
+        throw std::system_error(errno, std::generic_category(), message);
+    }
+
+    int m_fd;
+    bool m_direct;
+};
+
+// Scatter-gather I/O over a stack of buffers, each of which holds
+// bufferBytes.  Buffers are gathered into iovec arrays of at most IOV_MAX
+// entries, so a stack of any size is transferred with one system call per
+// batch rather than one per buffer.
+//
+// Each transfer continues through partial reads and writes, and returns the
+// total number of bytes transferred.  That total is short only at the end of
+// the file for reads, or if a non-blocking descriptor would block.
+
+inline std::size_t iovMax()
+{
+#if defined(IOV_MAX)
+    return IOV_MAX;
+#else
+    return 1024;
+#endif
+}
+
+// Transfer the buffers of a stack using op, which performs a single vectored
+// system call for an iovec array, given the number of bytes transferred so
+// far, and returns its result.
+template<typename T, typename Op>
+std::size_t transferStack(
+        const Stack<T*>& stack,
+        std::size_t bufferBytes,
+        Op op)
+{
+    std::vector<iovec> iov;
+    iov.reserve(std::min(iovMax(), stack.size()));
+
+    const Node<T*>* node(stack.head());
+    std::size_t skip(0);    // Bytes already transferred within this node.
+    std::size_t total(0);
+
+    while (node)
+    {
+        iov.clear();
+
+        for (
+                const Node<T*>* current(node);
+                current && iov.size() < iovMax();
+                current = current->next())
+        {
+            const std::size_t offset(current == node ? skip : 0);
+
+            iovec entry;
+            entry.iov_base = reinterpret_cast<char*>(current->val()) + offset;
+            entry.iov_len = bufferBytes - offset;
+            iov.push_back(entry);
+        }
+
+        const ssize_t result(op(iov.data(), iov.size(), total));
+
+        if (result < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+
+            throw std::system_error(
+                    errno,
+                    std::generic_category(),
+                    "Vectored I/O failed");
+        }
+
+        if (!result) break;
+
+        total += result;
+
+        // Step past every buffer which has been completed.
+        std::size_t remaining(result);
+
+        while (remaining)
+        {
+            const std::size_t available(bufferBytes - skip);
+
+            if (remaining >= available)
+            {
+                remaining -= available;
+                node = node->next();
+                skip = 0;
+            }
+            else
+            {
+                skip += remaining;
+                remaining = 0;
+            }
+        }
+    }
+
+    return total;
+}
+
+// After reading total bytes into a stack of buffers, release the buffers
+// which received no data back to their pool.
+template<typename T>
+void releaseUnused(
+        UniqueStack<T*>& stack,
+        std::size_t bufferBytes,
+        std::size_t total)
+{
+    const std::size_t used((total + bufferBytes - 1) / bufferBytes);
+    stack = stack.pop(used);
+}
+
+template<typename T>
+std::size_t writeStack(int fd, const Stack<T*>& stack, std::size_t bufferBytes)
+{
+    return transferStack(
+            stack,
+            bufferBytes,
+            [fd](const iovec* iov, std::size_t n, std::size_t)
+            {
+                return ::writev(fd, iov, n);
+            });
+}
+
+template<typename T>
+std::size_t readStack(int fd, const Stack<T*>& stack, std::size_t bufferBytes)
+{
+    return transferStack(
+            stack,
+            bufferBytes,
+            [fd](const iovec* iov, std::size_t n, std::size_t)
+            {
+                return ::readv(fd, iov, n);
+            });
+}
+
+// The positional variants pass flags (e.g. RWF_HIPRI or RWF_DSYNC) through
+// to pwritev2/preadv2 where they are available.  Elsewhere, flags must be
+// zero.
+template<typename T>
+std::size_t pwriteStack(
+        int fd,
+        const Stack<T*>& stack,
+        std::size_t bufferBytes,
+        off_t offset,
+        int flags = 0)
+{
+    return transferStack(
+            stack,
+            bufferBytes,
+            [fd, offset, flags](
+                const iovec* iov,
+                std::size_t n,
+                std::size_t done) -> ssize_t
+            {
+#if defined(RWF_HIPRI)
+                return ::pwritev2(fd, iov, n, offset + done, flags);
+#else
+                if (flags) { errno = ENOTSUP; return -1; }
+                return ::pwritev(fd, iov, n, offset + done);
+#endif
+            });
+}
+
+template<typename T>
+std::size_t preadStack(
+        int fd,
+        const Stack<T*>& stack,
+        std::size_t bufferBytes,
+        off_t offset,
+        int flags = 0)
+{
+    return transferStack(
+            stack,
+            bufferBytes,
+            [fd, offset, flags](
+                const iovec* iov,
+                std::size_t n,
+                std::size_t done) -> ssize_t
+            {
+#if defined(RWF_HIPRI)
+                return ::preadv2(fd, iov, n, offset + done, flags);
+#else
+                if (flags) { errno = ENOTSUP; return -1; }
+                return ::preadv(fd, iov, n, offset + done);
+#endif
+            });
+}
+
+// Pooled variants of the above.  Reads release any buffers which received
+// no data back to the pool.
+template<typename T>
+std::size_t writeStack(
+        int fd,
+        const UniqueStack<T*>& stack,
+        std::size_t bufferBytes)
+{
+    return writeStack(fd, stack.stack(), bufferBytes);
+}
+
+template<typename T>
+std::size_t readStack(int fd, UniqueStack<T*>& stack, std::size_t bufferBytes)
+{
+    const std::size_t total(readStack(fd, stack.stack(), bufferBytes));
+    releaseUnused(stack, bufferBytes, total);
+    return total;
+}
+
+template<typename T>
+std::size_t pwriteStack(
+        int fd,
+        const UniqueStack<T*>& stack,
+        std::size_t bufferBytes,
+        off_t offset,
+        int flags = 0)
+{
+    return pwriteStack(fd, stack.stack(), bufferBytes, offset, flags);
+}
+
+template<typename T>
+std::size_t preadStack(
+        int fd,
+        UniqueStack<T*>& stack,
+        std::size_t bufferBytes,
+        off_t offset,
+        int flags = 0)
+{
+    const std::size_t total(
+            preadStack(fd, stack.stack(), bufferBytes, offset, flags));
+
+    releaseUnused(stack, bufferBytes, total);
+    return total;
+}
+
+} // namespace splicer
@@ -0,0 +1,408 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+template<typename T> struct DItem;
+
+// A doubly-linked node is an ordinary pooled Node whose value carries a back
+// link, so it is acquired from and released to an ordinary SplicePool - for
+// example an ObjectPool<DItem<T>> - and a whole DList is a valid Stack.
+template<typename T>
+using DNode = Node<DItem<T>>;
+
+// True for a single argument which is itself a DItem, which should be copied
+// or moved rather than forwarded as the value.
+template<typename T, typename... Args>
+struct IsDItem : std::false_type { };
+
+template<typename T, typename Arg>
+struct IsDItem<T, Arg>
+    : std::is_same<typename std::decay<Arg>::type, DItem<T>> { };
+
+template<typename T>
+struct DItem
+{
+    template<
+        typename... Args,
+        typename = typename std::enable_if<
+            !IsDItem<T, Args...>::value>::type>
+    explicit DItem(Args&&... args)
+        : val(std::forward<Args>(args)...)
+        , prev(nullptr)
+    { }
+
+    T& operator*() { return val; }
+    const T& operator*() const { return val; }
+
+    T* operator->() { return &val; }
+    const T* operator->() const { return &val; }
+
+    T val;
+    DNode<T>* prev;
+};
+
+// A doubly-linked list of DNodes, with O(1) push and pop at both ends, O(1)
+// unlinking of any node, and O(1) splicing of whole lists.  Forward links are
+// the next pointers of the nodes, so a DList is released to its pool as a
+// Stack in O(1).  Adopting a Stack from a pool requires a single pass to set
+// the back links.
+template<typename T>
+class DList
+{
+public:
+    using Item = DItem<T>;
+    using NodeType = DNode<T>;
+
+    DList() : m_head(nullptr), m_tail(nullptr), m_size(0) { }
+
+    explicit DList(Stack<Item>&& stack)
+        : m_head(stack.head())
+        , m_tail(stack.tail())
+        , m_size(stack.size())
+    {
+        NodeType* prev(nullptr);
+
+        for (NodeType* node(m_head); node; node = node->next())
+        {
+            node->val().prev = prev;
+            prev = node;
+        }
+
+        stack = Stack<Item>();
+    }
+
+    DList(DList&& other)
+        : m_head(other.m_head)
+        , m_tail(other.m_tail)
+        , m_size(other.m_size)
+    {
+        other.clear();
+    }
+
+    DList& operator=(DList&& other)
+    {
+        m_head = other.m_head;
+        m_tail = other.m_tail;
+        m_size = other.m_size;
+        other.clear();
+        return *this;
+    }
+
+    // Give up every node, as a Stack which may be released to the pool.
+    Stack<Item> release()
+    {
+        Stack<Item> stack(m_head, m_tail, m_size);
+        clear();
+        return stack;
+    }
+
+    // Push to front.
+    void push(NodeType* node) { insertBefore(m_head, node); }
+
+    // Push to back.
+    void pushBack(NodeType* node) { insertAfter(m_tail, node); }
+
+    // Splice all of other to our front, leaving it empty.
+    void push(DList& other)
+    {
+        if (other.empty()) return;
+
+        if (empty())
+        {
+            swap(other);
+            return;
+        }
+
+        other.m_tail->setNext(m_head);
+        m_head->val().prev = other.m_tail;
+        m_head = other.m_head;
+        m_size += other.m_size;
+        other.clear();
+    }
+
+    // Splice all of other to our back, leaving it empty.
+    void pushBack(DList& other)
+    {
+        if (other.empty()) return;
+
+        if (empty())
+        {
+            swap(other);
+            return;
+        }
+
+        m_tail->setNext(other.m_head);
+        other.m_head->val().prev = m_tail;
+        m_tail = other.m_tail;
+        m_size += other.m_size;
+        other.clear();
+    }
+
+    // Insert a node ahead of pos, or at the back if pos is null.
+    void insertBefore(NodeType* pos, NodeType* node)
+    {
+        if (!pos) insertAfter(m_tail, node);
+        else insertAfter(pos->val().prev, node);
+    }
+
+    // Insert a node following pos, or at the front if pos is null.
+    void insertAfter(NodeType* pos, NodeType* node)
+    {
+        NodeType* next(pos ? pos->next() : m_head);
+
+        node->val().prev = pos;
+        node->setNext(next);
+
+        if (pos) pos->setNext(node);
+        else m_head = node;
+
+        if (next) next->val().prev = node;
+        else m_tail = node;
+
+        ++m_size;
+    }
+
+    // Remove a node, which must belong to this list, from wherever it is.
+    NodeType* unlink(NodeType* node)
+    {
+        assert(node && m_size);
+
+        NodeType* prev(node->val().prev);
+        NodeType* next(node->next());
+
+        if (prev) prev->setNext(next);
+        else m_head = next;
+
+        if (next) next->val().prev = prev;
+        else m_tail = prev;
+
+        node->setNext(nullptr);
+        node->val().prev = nullptr;
+        --m_size;
+
+        return node;
+    }
+
+    NodeType* pop() { return m_head ? unlink(m_head) : nullptr; }
+    NodeType* popBack() { return m_tail ? unlink(m_tail) : nullptr; }
+
+    // Move a node of this list to the front.
+    void moveToFront(NodeType* node)
+    {
+        if (node == m_head) return;
+        push(unlink(node));
+    }
+
+    void swap(DList& other)
+    {
+        std::swap(m_head, other.m_head);
+        std::swap(m_tail, other.m_tail);
+        std::swap(m_size, other.m_size);
+    }
+
+    bool empty() const { return !m_head; }
+    std::size_t size() const { return m_size; }
+
+    NodeType* head() { return m_head; }
+    const NodeType* head() const { return m_head; }
+
+    NodeType* tail() { return m_tail; }
+    const NodeType* tail() const { return m_tail; }
+
+    template<typename N, typename V, bool Reverse>
+    class BasicIterator
+    {
+    public:
+        explicit BasicIterator(N* node) : m_node(node) { }
+
+        BasicIterator& operator++()
+        {
+            m_node = Reverse ? m_node->val().prev : m_node->next();
+            return *this;
+        }
+
+        V& operator*() const { return m_node->val().val; }
+        N* node() const { return m_node; }
+
+        bool operator!=(const BasicIterator& other) const
+        {
+            return m_node != other.m_node;
+        }
+
+    private:
+        N* m_node;
+    };
+
+    using Iterator = BasicIterator<NodeType, T, false>;
+    using ConstIterator = BasicIterator<const NodeType, const T, false>;
+    using ReverseIterator = BasicIterator<NodeType, T, true>;
+
+    Iterator begin() { return Iterator(m_head); }
+    Iterator end() { return Iterator(nullptr); }
+
+    ConstIterator begin() const { return ConstIterator(m_head); }
+    ConstIterator end() const { return ConstIterator(nullptr); }
+
+    ReverseIterator rbegin() { return ReverseIterator(m_tail); }
+    ReverseIterator rend() { return ReverseIterator(nullptr); }
+
+private:
+    DList(const DList&) = delete;
+    DList& operator=(const DList&) = delete;
+
+    void clear()
+    {
+        m_head = nullptr;
+        m_tail = nullptr;
+        m_size = 0;
+    }
+
+    NodeType* m_head;
+    NodeType* m_tail;
+    std::size_t m_size;
+};
+
+// A DList which releases its nodes to their pool, as a single Stack, when it
+// is destroyed or reset.
+template<typename T>
+class UniqueDList
+{
+public:
+    using Item = DItem<T>;
+    using NodeType = DNode<T>;
+    using UniqueNodeType = UniqueNode<Item>;
+    using UniqueStackType = UniqueStack<Item>;
+
+    using Iterator = typename DList<T>::Iterator;
+    using ConstIterator = typename DList<T>::ConstIterator;
+    using ReverseIterator = typename DList<T>::ReverseIterator;
+
+    explicit UniqueDList(SplicePool<Item>& splicePool)
+        : m_splicePool(splicePool)
+        , m_list()
+    { }
+
+    // Adopt the nodes of a stack, typically fresh from the pool.
+    explicit UniqueDList(UniqueStackType&& stack)
+        : m_splicePool(stack.pool())
+        , m_list(stack.release())
+    { }
+
+    UniqueDList(UniqueDList&& other)
+        : m_splicePool(other.m_splicePool)
+        , m_list(other.release())
+    { }
+
+    UniqueDList& operator=(UniqueDList&& other)
+    {
+        reset();
+        m_list = other.release();
+        return *this;
+    }
+
+    ~UniqueDList() { reset(); }
+
+    DList<T> release()
+    {
+        DList<T> list(std::move(m_list));
+        return list;
+    }
+
+    void reset() { m_splicePool.release(m_list.release()); }
+
+    void push(UniqueNodeType&& node) { m_list.push(node.release()); }
+    void pushBack(UniqueNodeType&& node) { m_list.pushBack(node.release()); }
+
+    void push(UniqueDList&& other)
+    {
+        DList<T> pushing(other.release());
+        m_list.push(pushing);
+    }
+
+    void pushBack(UniqueDList&& other)
+    {
+        DList<T> pushing(other.release());
+        m_list.pushBack(pushing);
+    }
+
+    void insertBefore(NodeType* pos, UniqueNodeType&& node)
+    {
+        m_list.insertBefore(pos, node.release());
+    }
+
+    void insertAfter(NodeType* pos, UniqueNodeType&& node)
+    {
+        m_list.insertAfter(pos, node.release());
+    }
+
+    UniqueNodeType unlink(NodeType* node)
+    {
+        return UniqueNodeType(m_splicePool, m_list.unlink(node));
+    }
+
+    UniqueNodeType pop() { return UniqueNodeType(m_splicePool, m_list.pop()); }
+
+    UniqueNodeType popBack()
+    {
+        return UniqueNodeType(m_splicePool, m_list.popBack());
+    }
+
+    void moveToFront(NodeType* node) { m_list.moveToFront(node); }
+
+    bool empty() const { return m_list.empty(); }
+    std::size_t size() const { return m_list.size(); }
+
+    NodeType* head() { return m_list.head(); }
+    NodeType* tail() { return m_list.tail(); }
+
+    const DList<T>& list() const { return m_list; }
+
+    Iterator begin() { return m_list.begin(); }
+    Iterator end() { return m_list.end(); }
+
+    ConstIterator begin() const { return m_list.begin(); }
+    ConstIterator end() const { return m_list.end(); }
+
+    ReverseIterator rbegin() { return m_list.rbegin(); }
+    ReverseIterator rend() { return m_list.rend(); }
+
+    SplicePool<Item>& pool() { return m_splicePool; }
+
+private:
+    UniqueDList(const UniqueDList&) = delete;
+    UniqueDList& operator=(const UniqueDList&) = delete;
+
+    SplicePool<Item>& m_splicePool;
+    DList<T> m_list;
+};
+
+} // namespace splicer
@@ -0,0 +1,291 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "splice-hash-map.hpp"
+
+namespace splicer
+{
+
+// A concurrent least-recently-used cache, sharded by key, whose entries are
+// nodes of a single ObjectPool.  Each entry is one node, which serves both
+// as the entry in the HashMap index of its shard and as a link in the
+// recency list of that shard, so an insertion needs no allocation beyond
+// the node itself.
+//
+// The capacity is divided exactly among the shards.  Every shard acquires
+// the nodes for its share when the cache is constructed, and evicts before
+// inserting once full, so the pool never grows afterward.  An eviction reuses
+// the node of its victim in place for the new entry, so steady-state
+// insertion does not touch the pool at all.  Bulk invalidations release
+// their entries as a single Stack.
+template<
+    typename K,
+    typename V,
+    typename Hash = std::hash<K>,
+    typename Equal = std::equal_to<K>>
+class LruCache
+{
+    struct Slot;
+
+public:
+    using Map = HashMap<K, Slot, Hash, Equal>;
+    using Entry = typename Map::Entry;
+    using Pool = typename Map::Pool;
+
+    // There are never more shards than entries, so that every shard holds at
+    // least one.
+    explicit LruCache(std::size_t capacity, std::size_t shards = 16)
+        : m_capacity(std::max<std::size_t>(capacity, 1))
+        , m_pool(perShard(m_capacity, shardCount(m_capacity, shards), 0))
+        , m_shards()
+    {
+        const std::size_t count(shardCount(m_capacity, shards));
+
+        for (std::size_t i(0); i < count; ++i)
+        {
+            m_shards.emplace_back(
+                    new Shard(m_pool, perShard(m_capacity, count, i)));
+        }
+    }
+
+    std::size_t capacity() const { return m_capacity; }
+
+    std::size_t size() const
+    {
+        std::size_t total(0);
+
+        for (const auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->map.size();
+        }
+
+        return total;
+    }
+
+    // Copy the value for this key into out and mark it as most recently
+    // used, returning false if it is not cached.
+    bool get(const K& key, V& out)
+    {
+        Shard& shard(shardFor(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        Entry* entry(shard.map.findEntry(key));
+        if (!entry) return false;
+
+        shard.touch(entry);
+        out = entry->second.value;
+        return true;
+    }
+
+    // Does not affect recency.
+    bool contains(const K& key) const
+    {
+        const Shard& shard(shardFor(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.map.contains(key);
+    }
+
+    // Insert or overwrite a value, as most recently used, evicting the least
+    // recently used entry of its shard if necessary.
+    void put(const K& key, const V& value)
+    {
+        Shard& shard(shardFor(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        if (Entry* entry = shard.map.findEntry(key))
+        {
+            entry->second.value = value;
+            shard.touch(entry);
+            return;
+        }
+
+        Entry* entry(
+                shard.map.size() >= shard.capacity ?
+                    shard.evict(key) : shard.map.emplace(key).first);
+        entry->second.value = value;
+        shard.link(entry);
+    }
+
+    bool erase(const K& key)
+    {
+        Shard& shard(shardFor(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        Entry* entry(shard.map.findEntry(key));
+        if (!entry) return false;
+
+        shard.unlink(entry);
+        return shard.map.erase(key);
+    }
+
+    // Erase every entry for which f(key, value) returns true.  The entries of
+    // each shard are released to the pool together.
+    template<typename F>
+    std::size_t eraseIf(F f)
+    {
+        std::size_t count(0);
+
+        for (auto& s : m_shards)
+        {
+            Shard& shard(*s);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            count += shard.map.eraseIf([&shard, &f](Entry& entry)
+            {
+                if (!f(entry.first, entry.second.value)) return false;
+
+                shard.unlink(&entry);
+                return true;
+            });
+        }
+
+        return count;
+    }
+
+    // Release every entry, a whole shard at a time.
+    void clear()
+    {
+        for (auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->map.clear();
+            shard->head = nullptr;
+            shard->tail = nullptr;
+        }
+    }
+
+    const Pool& pool() const { return m_pool; }
+
+private:
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    struct Slot
+    {
+        Slot() : value(), prev(nullptr), next(nullptr) { }
+
+        V value;
+        Entry* prev;
+        Entry* next;
+    };
+
+    // Entries run from most recently used at the head to least recently used
+    // at the tail.
+    struct Shard
+    {
+        Shard(Pool& pool, std::size_t capacity)
+            : capacity(capacity)
+            , mutex()
+            , map(pool, capacity)
+            , head(nullptr)
+            , tail(nullptr)
+        {
+            map.reserve(capacity);
+        }
+
+        void link(Entry* entry)
+        {
+            Slot& slot(entry->second);
+            slot.prev = nullptr;
+            slot.next = head;
+
+            if (head) head->second.prev = entry;
+            else tail = entry;
+
+            head = entry;
+        }
+
+        void unlink(Entry* entry)
+        {
+            Slot& slot(entry->second);
+
+            if (slot.prev) slot.prev->second.next = slot.next;
+            else head = slot.next;
+
+            if (slot.next) slot.next->second.prev = slot.prev;
+            else tail = slot.prev;
+
+            slot.prev = nullptr;
+            slot.next = nullptr;
+        }
+
+        void touch(Entry* entry)
+        {
+            if (entry == head) return;
+            unlink(entry);
+            link(entry);
+        }
+
+        // Evict the least recently used entry, reusing its node as the entry
+        // for this key, which is returned unlinked from the recency list.
+        Entry* evict(const K& key)
+        {
+            Entry* victim(tail);
+            unlink(victim);
+            return map.replace(victim->first, key);
+        }
+
+        const std::size_t capacity;
+        mutable std::mutex mutex;
+        Map map;
+        Entry* head;
+        Entry* tail;
+    };
+
+    static std::size_t shardCount(std::size_t capacity, std::size_t shards)
+    {
+        return std::min(std::max<std::size_t>(shards, 1), capacity);
+    }
+
+    // The share of the capacity held by shard i.  The remainder is spread
+    // one entry apiece over the first shards, so shard 0 holds the most.
+    static std::size_t perShard(
+            std::size_t capacity,
+            std::size_t shards,
+            std::size_t i)
+    {
+        return capacity / shards + (i < capacity % shards ? 1 : 0);
+    }
+
+    Shard& shardFor(const K& key) const
+    {
+        return *m_shards[Hash()(key) % m_shards.size()];
+    }
+
+    const std::size_t m_capacity;
+
+    // The block size is the largest share, so that each shard acquires its
+    // nodes with a single acquire() served by at most one block.
+    Pool m_pool;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+} // namespace splicer
@@ -0,0 +1,389 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// An object pool whose nodes live in a memory-mapped file, so that a later
+// process may reopen the file and recover both the free list of the pool
+// and any stacks stored in its root slots, without rebuilding them.
+//
+// The file records every link outside of the nodes themselves - the free
+// list and the roots - as an offset from the start of the mapping.  Links
+// between nodes are native pointers, so that Stack operations pay nothing
+// for persistence, and the file records the address at which it was last
+// mapped.  Reopening first requests that same address, in which case
+// recovery is O(1).  Otherwise, the free list and the roots are relinked
+// for the new address in a single pass.
+//
+// The file is consistent only after sync() and upon destruction.  Nodes
+// which are neither available nor stored in a root at that point are not
+// recoverable.  T must be trivially copyable, and a file may be opened by
+// only one pool at a time.
+template<typename T>
+class PersistentPool : public SplicePool<T>
+{
+    static_assert(
+            std::is_trivially_copyable<T>::value,
+            "Persistent types must be trivially copyable");
+
+public:
+    using UniqueStackType = typename SplicePool<T>::UniqueStackType;
+
+    static const std::size_t rootCount = 16;
+
+    // Open the pool at this path, or create it with room for capacity nodes
+    // (rounded up to a whole number of blocks) if it does not exist.  The
+    // capacity of an existing pool is fixed at its creation.
+    PersistentPool(
+            const std::string& path,
+            std::size_t capacity,
+            std::size_t blockSize = 4096)
+        : SplicePool<T>(blockSize)
+        , m_fd(-1)
+        , m_size(0)
+        , m_data(nullptr)
+        , m_relocated(false)
+        , m_mutex()
+    {
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (m_fd < 0) fail("Could not open " + path);
+
+        try
+        {
+            struct stat st;
+            if (::fstat(m_fd, &st)) fail("Could not stat " + path);
+
+            if (st.st_size) open(st.st_size);
+            else create((capacity + blockSize - 1) / blockSize * blockSize);
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+    }
+
+    ~PersistentPool()
+    {
+        sync();
+        unmap();
+    }
+
+    std::size_t capacity() const { return header().capacity; }
+
+    // True if the file could not be mapped at its previous address, and so
+    // its links were rebased when it was opened.
+    bool relocated() const { return m_relocated; }
+
+    const void* data() const { return m_data; }
+
+    // Store a stack in a root slot, replacing whatever was stored there.
+    // The nodes of the stack are owned by the slot until they are taken.
+    void store(std::size_t slot, Stack<T>&& stack)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Root& root(header().roots[check(slot)]);
+
+        if (root.size)
+        {
+            Stack<T> previous(load(root));
+            this->release(std::move(previous));
+        }
+
+        root.head = offset(stack.head());
+        root.tail = offset(stack.tail());
+        root.size = stack.size();
+
+        stack = Stack<T>();
+    }
+
+    void store(std::size_t slot, UniqueStackType&& stack)
+    {
+        store(slot, stack.release());
+    }
+
+    // Take ownership of the stack stored in a root slot, leaving it empty.
+    UniqueStackType take(std::size_t slot)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Root& root(header().roots[check(slot)]);
+        Stack<T> stack(load(root));
+        root = Root();
+
+        return UniqueStackType(*this, std::move(stack));
+    }
+
+    // Write the free list of the pool to the file, and flush the mapping.
+    void sync()
+    {
+        if (!m_data) return;
+
+        Stack<T> available(this->availableStack());
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            Root& root(header().available);
+            root.head = offset(available.head());
+            root.tail = offset(available.tail());
+            root.size = available.size();
+        }
+
+        ::msync(m_data, m_size, MS_SYNC);
+    }
+
+private:
+    struct Root
+    {
+        Root() : head(0), tail(0), size(0) { }
+
+        std::uint64_t head;
+        std::uint64_t tail;
+        std::uint64_t size;
+    };
+
+    struct Header
+    {
+        std::uint64_t magic;
+        std::uint64_t nodeSize;
+        std::uint64_t capacity;
+        std::uint64_t carved;
+        std::uint64_t base;
+
+        Root available;
+        Root roots[rootCount];
+    };
+
+    static std::uint64_t magicNumber() { return 0x73706c6963657231ull; }
+
+    static std::size_t nodesOffset()
+    {
+        const std::size_t align(std::max<std::size_t>(alignof(Node<T>), 64));
+        return (sizeof(Header) + align - 1) / align * align;
+    }
+
+    static void fail(const std::string& message)
+    {
+        throw std::system_error(errno, std::generic_category(), message);
+    }
+
+    std::size_t check(std::size_t slot) const
+    {
+        if (slot >= rootCount) throw std::out_of_range("Invalid root slot");
+        return slot;
+    }
+
+    Header& header() { return *static_cast<Header*>(m_data); }
+    const Header& header() const { return *static_cast<const Header*>(m_data); }
+
+    Node<T>* nodes()
+    {
+        return reinterpret_cast<Node<T>*>(
+                static_cast<char*>(m_data) + nodesOffset());
+    }
+
+    // Offsets are relative to the start of the mapping, where the header
+    // lives, so zero is never a valid node offset and represents null.
+    std::uint64_t offset(const Node<T>* node) const
+    {
+        if (!node) return 0;
+        return reinterpret_cast<const char*>(node) -
+            static_cast<const char*>(m_data);
+    }
+
+    Node<T>* pointer(std::uint64_t offset)
+    {
+        if (!offset) return nullptr;
+        return reinterpret_cast<Node<T>*>(static_cast<char*>(m_data) + offset);
+    }
+
+    Stack<T> load(const Root& root)
+    {
+        return Stack<T>(pointer(root.head), pointer(root.tail), root.size);
+    }
+
+    void map(std::size_t size, void* hint)
+    {
+        m_size = size;
+        m_data = ::mmap(
+                hint,
+                m_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                m_fd,
+                0);
+
+        if (m_data == MAP_FAILED)
+        {
+            m_data = nullptr;
+            fail("Could not map persistent pool");
+        }
+    }
+
+    void unmap()
+    {
+        if (m_data) ::munmap(m_data, m_size);
+        if (m_fd >= 0) ::close(m_fd);
+
+        m_data = nullptr;
+        m_fd = -1;
+    }
+
+    void create(std::size_t capacity)
+    {
+        const std::size_t size(nodesOffset() + capacity * sizeof(Node<T>));
+        if (::ftruncate(m_fd, size)) fail("Could not size persistent pool");
+
+        map(size, nullptr);
+
+        Header& h(header());
+        h.magic = magicNumber();
+        h.nodeSize = sizeof(Node<T>);
+        h.capacity = capacity;
+        h.carved = 0;
+        h.base = reinterpret_cast<std::uintptr_t>(m_data);
+        h.available = Root();
+        for (Root& root : h.roots) root = Root();
+    }
+
+    void open(std::size_t size)
+    {
+        Header existing;
+
+        if (size < sizeof(Header) ||
+                ::pread(m_fd, &existing, sizeof(Header), 0) !=
+                    static_cast<ssize_t>(sizeof(Header)) ||
+                existing.magic != magicNumber() ||
+                existing.nodeSize != sizeof(Node<T>) ||
+                size < nodesOffset() + existing.capacity * sizeof(Node<T>))
+        {
+            throw std::runtime_error("Invalid persistent pool file");
+        }
+
+        map(size, reinterpret_cast<void*>(existing.base));
+
+        Header& h(header());
+        const std::uintptr_t base(reinterpret_cast<std::uintptr_t>(m_data));
+
+        if (h.base != base)
+        {
+            m_relocated = true;
+            rebase(h.available, h.base);
+            for (Root& root : h.roots) rebase(root, h.base);
+            h.base = base;
+        }
+
+        Stack<T> available(load(h.available));
+        h.available = Root();
+
+        this->adopt(std::move(available), h.carved);
+    }
+
+    // Relink the chain of a root, whose node links were written while the
+    // file was mapped at a previous address.
+    void rebase(Root& root, std::uintptr_t previous)
+    {
+        const std::uintptr_t base(reinterpret_cast<std::uintptr_t>(m_data));
+
+        Stack<T> stack;
+        Node<T>* node(pointer(root.head));
+
+        while (node)
+        {
+            const std::uintptr_t next(
+                    reinterpret_cast<std::uintptr_t>(node->next()));
+
+            stack.pushBack(node);
+
+            node = next ?
+                reinterpret_cast<Node<T>*>(next - previous + base) :
+                nullptr;
+        }
+
+        assert(stack.size() == root.size);
+        root.tail = offset(stack.tail());
+    }
+
+    virtual Stack<T> doAllocate(std::size_t blocks) override
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Header& h(header());
+        const std::size_t count(blocks * this->m_blockSize);
+
+        if (h.carved + count > h.capacity) throw std::bad_alloc();
+
+        Stack<T> stack;
+        Node<T>* begin(nodes() + h.carved);
+
+        for (std::size_t i(0); i < count; ++i)
+        {
+            stack.push(new (begin + i) Node<T>());
+        }
+
+        h.carved += count;
+
+        return stack;
+    }
+
+    virtual void construct(T* val) const override
+    {
+        new (val) T();
+    }
+
+    int m_fd;
+    std::size_t m_size;
+    void* m_data;
+    bool m_relocated;
+
+    // Guards the header, other than the free list which is owned by the
+    // base pool while mapped.
+    mutable std::mutex m_mutex;
+};
+
+template<typename T>
+const std::size_t PersistentPool<T>::rootCount;
+
+} // namespace splicer
@@ -24,25 +24,45 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
 #include <deque>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace splicer
 {
 
 template<typename T> class Stack;
 template<typename T> class SplicePool;
 template<typename T> class UniqueStack;
+template<typename T> class MpscQueue;
+template<typename T> class DList;
 
 template<typename T>
 class Node
 {
     friend class Stack<T>;
+    friend class MpscQueue<T>;
+    template<typename U> friend class DList;
 
 public:
     explicit Node(Node* next = nullptr) : m_val(), m_next(next) { }
@@ -78,6 +98,107 @@ private:
     Node* m_next;
 };
 
+// Hint that this address will soon be read.  Null is harmless.
+inline void prefetch(const void* p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
+
+// The node addresses of a Stack, gathered by a single walk of its chain.
+// Walking the chain is a series of dependent loads, taking one cache miss at
+// a time, whereas the addresses in the index are independent.  Scans of the
+// index therefore prefetch the node a fixed distance ahead, overlapping many
+// misses.  Worthwhile for long stacks which are scanned repeatedly between
+// changes - any change to the Stack invalidates its index.
+template<typename N>
+class JumpIndex
+{
+public:
+    using Reference = decltype(std::declval<N&>().val());
+
+    class Iterator
+    {
+    public:
+        Iterator(N* const* pos, N* const* end, std::size_t distance)
+            : m_pos(pos)
+            , m_end(end)
+            , m_distance(distance)
+        { }
+
+        Iterator& operator++()
+        {
+            ++m_pos;
+            if (m_distance < static_cast<std::size_t>(m_end - m_pos))
+            {
+                prefetch(m_pos[m_distance]);
+            }
+            return *this;
+        }
+
+        Reference operator*() const { return (*m_pos)->val(); }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return m_pos != other.m_pos;
+        }
+
+    private:
+        N* const* m_pos;
+        N* const* m_end;
+        std::size_t m_distance;
+    };
+
+    // Gathers size nodes, beginning at head.
+    JumpIndex(N* head, std::size_t size, std::size_t distance)
+        : m_nodes()
+        , m_distance(distance)
+    {
+        m_nodes.reserve(size);
+
+        for (std::size_t i(0); i < size; ++i)
+        {
+            m_nodes.push_back(head);
+            head = head->next();
+        }
+    }
+
+    std::size_t size() const { return m_nodes.size(); }
+    bool empty() const { return m_nodes.empty(); }
+
+    N* operator[](std::size_t i) const { return m_nodes[i]; }
+
+    Iterator begin() const
+    {
+        const std::size_t warm(std::min(m_distance, m_nodes.size()));
+        for (std::size_t i(0); i < warm; ++i) prefetch(m_nodes[i]);
+
+        return Iterator(
+                m_nodes.data(),
+                m_nodes.data() + m_nodes.size(),
+                m_distance);
+    }
+
+    Iterator end() const
+    {
+        N* const* last(m_nodes.data() + m_nodes.size());
+        return Iterator(last, last, m_distance);
+    }
+
+    template<typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (Iterator it(begin()), stop(end()); it != stop; ++it) fn(*it);
+    }
+
+private:
+    std::vector<N*> m_nodes;
+    std::size_t m_distance;
+};
+
 template<typename T>
 class Stack
 {
@@ -86,6 +207,16 @@ class Stack
 public:
     Stack() : m_tail(nullptr), m_head(nullptr), m_size(0) { }
 
+    // Preconditions: head through tail form a chain of exactly size nodes,
+    // and tail->next() is null.
+    Stack(Node<T>* head, Node<T>* tail, std::size_t size)
+        : m_tail(tail)
+        , m_head(head)
+        , m_size(size)
+    {
+        assert(!m_tail || !m_tail->next());
+    }
+
     Stack(const Stack& other)
         : m_tail(other.m_tail)
         , m_head(other.m_head)
@@ -185,110 +316,231 @@ public:
 
     // Preconditions: this stack is sorted according to this comparator.
     //
-    // This operation has complexity O(n), n being the stack size.
+    // The node is inserted after any nodes with equal keys, so that pushing
+    // nodes one at a time is stable.
+    //
+    // This operation has complexity O(n), n being the stack size, or O(1) if
+    // the node does not compare less than the tail.
     template <typename Compare>
     void push(Node<T>* node, Compare compare)
     {
         assert(sortedBy(compare));
+        push(node, compare, nullptr);
+    }
 
+    // Preconditions: this stack is sorted according to this comparator, and
+    // the hint is null or a node of this stack.
+    //
+    // Sorted insertion which searches forward from the hint rather than from
+    // the head, unless the node compares less than the hint.  Returns the
+    // inserted node, to be passed as the hint for the next insertion.  As
+    // above, the node follows any nodes with equal keys, regardless of the
+    // hint.
+    template <typename Compare>
+    Node<T>* push(Node<T>* node, Compare compare, Node<T>* hint)
+    {
         if (empty() || compare(**node, **m_head))
         {
             push(node);
         }
+        else if (!compare(**node, **m_tail))
+        {
+            pushBack(node);
+        }
         else
         {
-            Node<T>* before(m_head);
+            if (!hint || compare(**node, **hint)) hint = m_head;
 
-            while (before->next() && compare(**before->next(), **node))
-            {
-                before = before->next();
-            }
+            while (!compare(**node, **hint->next())) hint = hint->next();
 
-            node->setNext(before->next());
-            before->setNext(node);
-
-            ++m_size;
+            pushAfter(hint, node);
         }
+
+        return node;
+    }
+
+    // Preconditions: this stack is sorted according to this comparator.
+    //
+    // Insert each node of the range, where each search begins from the
+    // previous insertion point.  Nearly sorted input costs close to O(1) per
+    // node - only nodes stepping backward rescan from the head.
+    template <typename Iter, typename Compare>
+    void pushSorted(Iter begin, Iter end, Compare compare)
+    {
+        assert(sortedBy(compare));
+
+        Node<T>* hint(nullptr);
+        while (begin != end) hint = push(*begin++, compare, hint);
+    }
+
+    // Insert each node of the other stack, in its order, as above.
+    template <typename Compare>
+    void pushSorted(Stack& other, Compare compare)
+    {
+        assert(sortedBy(compare));
+
+        Node<T>* hint(nullptr);
+        while (!other.empty()) hint = push(other.pop(), compare, hint);
     }
 
     // Preconditions: both this stack, and the incoming stack, are sorted
     // according to this comparator.
     //
-    // This operation has complexity O(m * n), where m and n are the sizes of
-    // the stacks.  It is intended only for stacks known to be small.
+    // Equivalent to merge(other, compare).
     template <typename Compare>
     void push(Stack& other, Compare compare)
+    {
+        merge(other, compare);
+    }
+
+    // Preconditions: both this stack, and the incoming stack, are sorted
+    // according to this comparator.
+    //
+    // Relink the nodes of both stacks into a single sorted stack, leaving the
+    // other stack empty.  The merge is stable: of nodes with equal keys, ours
+    // precede those of the other stack, and each retains its own order.
+    //
+    // This operation has complexity O(m + n), where m and n are the sizes of
+    // the stacks, and is O(1) when one stack falls entirely after the other.
+    template <typename Compare>
+    void merge(Stack& other, Compare compare)
     {
         assert(sortedBy(compare));
         assert(other.sortedBy(compare));
 
-        Node<T>* a(m_head);
-        Node<T>* b(other.head());
+        if (other.empty()) return;
 
-        if (!a)
+        if (empty() || !compare(**other.m_head, **m_tail))
         {
-            *this = other;
+            pushBack(other);
             return;
         }
-        else if (!b)
+
+        if (compare(**other.m_tail, **m_head))
         {
+            push(other);
             return;
         }
 
-        // Insert whatever we can from B prior to the start of A.
-        if (compare(**b, **a))
+        Node<T>* a(m_head);
+        Node<T>* b(other.m_head);
+
+        Node<T>* head(nullptr);
+        Node<T>** link(&head);
+
+        while (a && b)
         {
-            while (b->next() && compare(**b->next(), **a))
+            if (compare(**b, **a))
             {
-                b = b->next();
+                *link = b;
+                link = &b->m_next;
+                b = b->m_next;
             }
+            else
+            {
+                *link = a;
+                link = &a->m_next;
+                a = a->m_next;
+            }
+        }
 
-            Node<T>* nextB(b->next());
-            b->setNext(m_head);
-            b = nextB;
-
-            m_head = other.head();
+        if (a)
+        {
+            *link = a;
+        }
+        else
+        {
+            *link = b;
+            m_tail = other.m_tail;
         }
 
-        // At the top of this loop, the position of B needs to be inserted
-        // somewhere (but not necessarily immediately) after the position of A.
-        while (a && b)
+        m_head = head;
+        m_size += other.m_size;
+        other.clear();
+    }
+
+    // Sort this stack by relinking its nodes, with a stable bottom-up merge
+    // sort.  No values are copied and nothing is allocated.
+    //
+    // This operation has complexity O(n log n), and O(n) if the stack is
+    // already sorted.
+    template <typename Compare>
+    void sort(Compare compare)
+    {
+        if (m_size < 2) return;
+
+        // Bin i holds a sorted run of 2^i nodes, or is empty.  Bins hold
+        // earlier nodes than the carry, so merging into them is stable.
+        Stack bins[64];
+        std::size_t used(0);
+
+        while (!empty())
         {
-            // Either A < B, or !(B < A), i.e. A <= B.
-            assert(compare(**a, **b) || !compare(**b, **a));
+            Stack carry;
+            carry.push(pop());
 
-            // First, progress A to the point at which B should be inserted
-            // immediately after A.
-            while (a->next() && compare(**a->next(), **b))
+            std::size_t i(0);
+            while (i < used && !bins[i].empty())
             {
-                a = a->next();
+                bins[i].merge(carry, compare);
+                carry.swap(bins[i]);
+                ++i;
             }
 
-            // Then, insert the range starting with B, to the position ahead of
-            // B (e.g. B + n) such that compare(*(B + n), A.next()) == true.
-            Node<T>* nextA(a->next());
-            a->setNext(b);
-            a = nextA;
+            carry.swap(bins[i]);
+            if (i == used) ++used;
+        }
 
-            if (a)
-            {
-                // Splice the applicable range from B into A.
-                while (b->next() && compare(**b->next(), **a))
+        for (std::size_t i(0); i < used; ++i)
+        {
+            bins[i].merge(*this, compare);
+            swap(bins[i]);
+        }
+    }
+
+    // Sort this stack by keys extracted into a contiguous buffer first, so
+    // that comparisons do not chase node pointers.  This is preferable when
+    // values are large or far apart in memory, or comparisons of values are
+    // expensive relative to comparisons of keys.  Stable.
+    template <typename KeyFn, typename Compare>
+    void sortByKey(KeyFn key, Compare compare)
+    {
+        if (m_size < 2) return;
+
+        using Key = typename std::decay<decltype(key(**m_head))>::type;
+        std::vector<std::pair<Key, Node<T>*>> keyed;
+        keyed.reserve(m_size);
+
+        for (Node<T>* node(m_head); node; node = node->next())
+        {
+            keyed.emplace_back(key(**node), node);
+        }
+
+        std::stable_sort(
+                keyed.begin(),
+                keyed.end(),
+                [&compare](
+                    const std::pair<Key, Node<T>*>& a,
+                    const std::pair<Key, Node<T>*>& b)
                 {
-                    b = b->next();
-                }
+                    return compare(a.first, b.first);
+                });
 
-                Node<T>* nextB(b->next());
-                b->setNext(a);
-                b = nextB;
-            }
+        for (std::size_t i(1); i < keyed.size(); ++i)
+        {
+            keyed[i - 1].second->setNext(keyed[i].second);
         }
 
-        // If B is at the end, then the insertion is complete.  Otherwise,
-        // the rest of B needs to be appended to our tail.
-        if (b) m_tail = other.tail();
+        m_head = keyed.front().second;
+        m_tail = keyed.back().second;
+        m_tail->setNext(nullptr);
+    }
 
-        m_size += other.size();
+    template <typename KeyFn>
+    void sortByKey(KeyFn key)
+    {
+        using Key = typename std::decay<decltype(key(**m_head))>::type;
+        sortByKey(key, std::less<Key>());
     }
 
     Node<T>* pop()
@@ -296,8 +548,43 @@ public:
         Node<T>* node(m_head);
         if (m_head)
         {
-            m_head = m_head->next();
-            if (!--m_size) m_tail = nullptr;
+            // Rely on the size rather than the link of the tail, which may
+            // lead onward when this Stack is a section of a longer chain.
+            if (--m_size) m_head = m_head->next();
+            else clear();
+        }
+        return node;
+    }
+
+    // Insert a node following this one, which must belong to this Stack, or
+    // at the front if it is null.
+    void pushAfter(Node<T>* before, Node<T>* node)
+    {
+        if (!before)
+        {
+            push(node);
+            return;
+        }
+
+        node->setNext(before->next());
+        before->setNext(node);
+
+        if (before == m_tail) m_tail = node;
+        ++m_size;
+    }
+
+    // Pop the node following this one, which must belong to this Stack, or
+    // the head if it is null.
+    Node<T>* popAfter(Node<T>* before)
+    {
+        if (!before) return pop();
+
+        Node<T>* node(before->next());
+        if (node)
+        {
+            before->setNext(node->next());
+            if (node == m_tail) m_tail = before;
+            --m_size;
         }
         return node;
     }
@@ -361,6 +648,9 @@ public:
     Node<T>* head() { return m_head; }
     const Node<T>* head() const { return m_head; }
 
+    Node<T>* tail() { return m_tail; }
+    const Node<T>* tail() const { return m_tail; }
+
     class Iterator;
 
     class ConstIterator
@@ -444,6 +734,34 @@ public:
     ConstIterator end() const { return ConstIterator(nullptr); }
     ConstIterator cend() const { return end(); }
 
+    // Gather the node addresses for repeated scans which prefetch the node
+    // this many places ahead.
+    JumpIndex<Node<T>> jumpIndex(std::size_t distance = 16)
+    {
+        return JumpIndex<Node<T>>(m_head, m_size, distance);
+    }
+
+    JumpIndex<const Node<T>> jumpIndex(std::size_t distance = 16) const
+    {
+        return JumpIndex<const Node<T>>(m_head, m_size, distance);
+    }
+
+    // Call fn on each value in order.  The walk of the chain runs a batch of
+    // nodes ahead of the calls to fn, advancing one node per call, so each
+    // dependent load of the chain is issued a full call of fn before it is
+    // needed and overlaps that work rather than stalling on its own.
+    template<typename Fn>
+    void forEachBatch(Fn fn, std::size_t batch = 16)
+    {
+        forEachBatchFrom(m_head, m_size, fn, batch);
+    }
+
+    template<typename Fn>
+    void forEachBatch(Fn fn, std::size_t batch = 16) const
+    {
+        forEachBatchFrom(head(), m_size, fn, batch);
+    }
+
 protected:
     void clear()
     {
@@ -453,8 +771,52 @@ protected:
     }
 
 private:
-    Node<T>* tail() { return m_tail; }
-    const Node<T>* tail() const { return m_tail; }
+    template<typename N, typename Fn>
+    static void forEachBatchFrom(
+            N* node,
+            std::size_t size,
+            Fn& fn,
+            std::size_t batch)
+    {
+        const std::size_t maxBatch(64);
+        batch = std::max<std::size_t>(1, std::min(batch, maxBatch));
+
+        N* buffers[2][maxBatch];
+        N** current(buffers[0]);
+        N** next(buffers[1]);
+
+        // Fill the first batch up front.
+        std::size_t n(0);
+        while (n < batch && n < size)
+        {
+            current[n++] = node;
+            node = node->next();
+            prefetch(node);
+        }
+
+        std::size_t remaining(size - n);
+
+        while (n)
+        {
+            std::size_t m(0);
+
+            for (std::size_t i(0); i < n; ++i)
+            {
+                if (m < remaining)
+                {
+                    next[m++] = node;
+                    node = node->next();
+                    prefetch(node);
+                }
+
+                fn(current[i]->val());
+            }
+
+            remaining -= m;
+            std::swap(current, next);
+            n = m;
+        }
+    }
 
     Node<T>* m_tail;
     Node<T>* m_head;
@@ -631,6 +993,12 @@ public:
         m_stack.push(node, compare);
     }
 
+    template <typename Compare>
+    Node<T>* push(Node<T>* node, Compare compare, Node<T>* hint)
+    {
+        return m_stack.push(node, compare, hint);
+    }
+
     template <typename Compare>
     void push(Stack<T>& other, Compare compare)
     {
@@ -658,6 +1026,64 @@ public:
         m_stack.push(pushing, compare);
     }
 
+    // Hinted sorted insertion of nearly sorted input.
+    template <typename Iter, typename Compare>
+    void pushSorted(Iter begin, Iter end, Compare compare)
+    {
+        m_stack.pushSorted(begin, end, compare);
+    }
+
+    template <typename Compare>
+    void pushSorted(Stack<T>& other, Compare compare)
+    {
+        m_stack.pushSorted(other, compare);
+    }
+
+    template <typename Compare>
+    void pushSorted(Stack<T>&& other, Compare compare)
+    {
+        m_stack.pushSorted(other, compare);
+    }
+
+    template <typename Compare>
+    void pushSorted(UniqueStack&& other, Compare compare)
+    {
+        Stack<T> pushing(other.release());
+        m_stack.pushSorted(pushing, compare);
+    }
+
+    template <typename Compare>
+    void sort(Compare compare) { m_stack.sort(compare); }
+
+    template <typename KeyFn, typename Compare>
+    void sortByKey(KeyFn key, Compare compare)
+    {
+        m_stack.sortByKey(key, compare);
+    }
+
+    template <typename KeyFn>
+    void sortByKey(KeyFn key) { m_stack.sortByKey(key); }
+
+    // Stable O(m + n) merge of sorted stacks.
+    template <typename Compare>
+    void merge(Stack<T>& other, Compare compare)
+    {
+        m_stack.merge(other, compare);
+    }
+
+    template <typename Compare>
+    void merge(Stack<T>&& other, Compare compare)
+    {
+        m_stack.merge(other, compare);
+    }
+
+    template <typename Compare>
+    void merge(UniqueStack&& other, Compare compare)
+    {
+        Stack<T> merging(other.release());
+        m_stack.merge(merging, compare);
+    }
+
     template <typename Compare>
     bool sortedBy(Compare compare)
     {
@@ -700,6 +1126,10 @@ public:
     Node<T>* head() { return m_stack.head(); }
     const Node<T>* head() const { return m_stack.head(); }
 
+    // Read-only view of the underlying Stack, which remains owned by this
+    // UniqueStack.
+    const Stack<T>& stack() const { return m_stack; }
+
     Iterator begin() { return Iterator(head()); }
     ConstIterator begin() const { return ConstIterator(head()); }
     ConstIterator cbegin() const { return begin(); }
@@ -708,6 +1138,28 @@ public:
     ConstIterator end() const { return ConstIterator(nullptr); }
     ConstIterator cend() const { return end(); }
 
+    JumpIndex<Node<T>> jumpIndex(std::size_t distance = 16)
+    {
+        return m_stack.jumpIndex(distance);
+    }
+
+    JumpIndex<const Node<T>> jumpIndex(std::size_t distance = 16) const
+    {
+        return m_stack.jumpIndex(distance);
+    }
+
+    template<typename Fn>
+    void forEachBatch(Fn fn, std::size_t batch = 16)
+    {
+        m_stack.forEachBatch(fn, batch);
+    }
+
+    template<typename Fn>
+    void forEachBatch(Fn fn, std::size_t batch = 16) const
+    {
+        m_stack.forEachBatch(fn, batch);
+    }
+
     SplicePool<T>& pool() { return m_splicePool; }
 
 private:
@@ -730,8 +1182,12 @@ public:
 
     SplicePool(std::size_t blockSize)
         : m_blockSize(blockSize)
-        , m_stack()
+        , m_full()
+        , m_loose()
         , m_mutex()
+        , m_returned()
+        , m_lent(0)
+        , m_available(0)
         , m_allocated(0)
     { }
 
@@ -746,7 +1202,15 @@ public:
     std::size_t available() const
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        return m_stack.size();
+        return m_available;
+    }
+
+    // The number of full chunks on the free list.  A bulk acquire splices out
+    // each of these in O(1).
+    std::size_t fullChunks() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_full.size();
     }
 
     void release(UniqueNodeType&& node) { node.reset(); }
@@ -756,30 +1220,26 @@ public:
     {
         if (node)
         {
-            reset(&node->val());
+            if (resets()) reset(&node->val());
 
-            // TODO - For these single node releases, we could put them into a
-            // separate Stack to avoid blocking the entire pool, and only reach
-            // into it when some threshold is reached or the main stack is
-            // empty.
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_stack.push(node);
+            m_loose.push(node);
+            ++m_available;
         }
     }
 
+    // Only pointers are spliced here.  A Stack of exactly one block's worth of
+    // nodes becomes a full chunk; any other Stack goes onto the loose nodes
+    // intact and is cut later, when it is acquired.
     void release(Stack<T>&& other)
     {
-        if (Node<T>* node = other.head())
-        {
-            while (node)
-            {
-                reset(&node->val());
-                node = node->next();
-            }
+        if (other.empty()) return;
 
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_stack.push(other);
-        }
+        if (resets()) reset(other);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_available += other.size();
+        give(other);
     }
 
     template<class... Args>
@@ -788,8 +1248,24 @@ public:
         UniqueNodeType node(*this);
 
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            node.reset(m_stack.pop());
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            while (m_loose.empty() && m_full.empty() && m_lent)
+            {
+                m_returned.wait(lock);
+            }
+
+            if (m_loose.empty() && !m_full.empty())
+            {
+                m_loose = std::move(m_full.back());
+                m_full.pop_back();
+            }
+
+            if (!m_loose.empty())
+            {
+                node.reset(m_loose.pop());
+                --m_available;
+            }
         }
 
         if (!node)
@@ -800,7 +1276,8 @@ public:
             std::lock_guard<std::mutex> lock(m_mutex);
 
             m_allocated += m_blockSize;
-            m_stack.push(newStack);
+            m_available += newStack.size();
+            give(newStack);
         }
 
         if (!std::is_pointer<T>::value)
@@ -811,40 +1288,86 @@ public:
         return node;
     }
 
+    // Under the lock, full chunks are spliced out whole in O(1) each.  A
+    // remainder comes from the loose nodes.  These are taken out all at once
+    // and cut after the lock is released, then the surplus is given back.
+    // While loose nodes are out being cut, an acquirer that would otherwise
+    // have to allocate waits for them to return.
     UniqueStackType acquire(const std::size_t count)
     {
-        UniqueStackType other(*this);
+        Stack<T> taken;
 
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (count >= m_stack.size())
         {
-            other = UniqueStackType(*this, std::move(m_stack));
+            std::unique_lock<std::mutex> lock(m_mutex);
 
-            lock.unlock();
-
-            if (count > other.size())
+            while (taken.size() < count)
             {
-                const std::size_t numNodes(count - other.size());
-                const std::size_t numBlocks(numNodes / m_blockSize + 1);
-
-                Stack<T> alloc(doAllocate(numBlocks));
+                const std::size_t needed(count - taken.size());
 
-                assert(alloc.size() == numBlocks * m_blockSize);
+                if (needed >= m_blockSize && !m_full.empty())
+                {
+                    taken.push(m_full.back());
+                    m_full.pop_back();
+                }
+                else if (!m_loose.empty() && m_loose.size() <= needed)
+                {
+                    taken.push(m_loose);
+                }
+                else if (!m_loose.empty())
+                {
+                    Stack<T> loose(std::move(m_loose));
+                    m_lent += loose.size() - needed;
 
-                Stack<T> taken(alloc.popStack(numNodes));
-                other.push(taken);
+                    lock.unlock();
+                    Stack<T> part(loose.popStack(needed));
+                    taken.push(part);
+                    lock.lock();
 
-                lock.lock();
-                m_stack.push(alloc);
-                m_allocated += numBlocks * m_blockSize;
+                    m_lent -= loose.size();
+                    m_loose.push(loose);
+                    m_returned.notify_all();
+                }
+                else if (!m_full.empty())
+                {
+                    // Fewer than a block's worth is needed, so break open a
+                    // full chunk to be cut as loose nodes.
+                    m_loose = std::move(m_full.back());
+                    m_full.pop_back();
+                }
+                else if (m_lent)
+                {
+                    m_returned.wait(lock);
+                }
+                else
+                {
+                    break;
+                }
             }
+
+            m_available -= taken.size();
         }
-        else
+
+        if (taken.size() < count)
         {
-            other = UniqueStackType(*this, m_stack.popStack(count));
+            const std::size_t numNodes(count - taken.size());
+            const std::size_t numBlocks(
+                    (numNodes + m_blockSize - 1) / m_blockSize);
+
+            Stack<T> alloc(doAllocate(numBlocks));
+
+            assert(alloc.size() == numBlocks * m_blockSize);
+
+            Stack<T> more(alloc.popStack(numNodes));
+            taken.push(more);
+
+            // Less than a block's worth is left over, so these are loose.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_allocated += numBlocks * m_blockSize;
+            m_available += alloc.size();
+            give(alloc);
         }
 
-        return other;
+        return UniqueStackType(*this, std::move(taken));
     }
 
 protected:
@@ -854,19 +1377,114 @@ protected:
         construct(val);
     }
 
+    // Reset every value of a Stack being released.  Pools which can reset
+    // many values more efficiently at once than one by one may override this.
+    virtual void reset(Stack<T>& stack)
+    {
+        for (Node<T>* node(stack.head()); node; node = node->next())
+        {
+            reset(&node->val());
+        }
+    }
+
     virtual Stack<T> doAllocate(std::size_t blocks) = 0;
     virtual void construct(T*) const { }
     virtual void destruct(T*) const { }
 
+    // Pools whose released values need no reset may return false here, in
+    // which case releasing a Stack only splices pointers.
+    virtual bool resets() const { return true; }
+
+    // A shallow copy of the available nodes, for pools which persist them.
+    // The free list is linked into a single chain but otherwise left in place.
+    Stack<T> availableStack()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_lent) m_returned.wait(lock);
+        return chain();
+    }
+
+    // Take over available nodes, and the count of allocated nodes, from a
+    // previous instance of a persistent pool.
+    void adopt(Stack<T>&& available, std::size_t allocated)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_available += available.size();
+        m_allocated += allocated;
+        give(available);
+    }
+
+    // Give up every available node, which is no longer counted as allocated,
+    // for pools which return nodes to storage shared with other instances.
+    Stack<T> surrender()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_lent) m_returned.wait(lock);
+
+        Stack<T> available(chain());
+        m_full.clear();
+        m_loose = Stack<T>();
+        m_allocated -= available.size();
+        m_available = 0;
+        return available;
+    }
+
+    // Stop counting nodes which have been handed over to another instance.
+    void disown(std::size_t count)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        assert(count <= m_allocated);
+        m_allocated -= count;
+    }
+
     const std::size_t m_blockSize;
 
 private:
     SplicePool(const SplicePool&) = delete;
     SplicePool& operator=(const SplicePool&) = delete;
 
-    Stack<T> m_stack;
+    // Add nodes to the free list, with the lock held, in O(1) and without
+    // updating the available count.
+    void give(Stack<T>& stack)
+    {
+        if (stack.size() == m_blockSize) m_full.push_back(std::move(stack));
+        else m_loose.push(stack);
+    }
+
+    // Link the full chunks and then the loose nodes into a single chain, with
+    // the lock held.  The chunks are left unchanged, except that the tail of
+    // each one except the first now links on to the next.
+    Stack<T> chain() const
+    {
+        Stack<T> all;
+
+        for (const Stack<T>& chunk : m_full)
+        {
+            Stack<T> linking(chunk);
+            all.push(linking);
+        }
+
+        Stack<T> linking(m_loose);
+        all.push(linking);
+
+        return all;
+    }
+
+    // The available nodes.  Full chunks each hold exactly one block's worth,
+    // so bulk transfers can splice them whole.  All other available nodes are
+    // kept together as loose nodes, which are cut only outside the lock.
+    // Sizes mark where each chunk ends, because chain() may link a tail on
+    // to the next chunk.
+    std::vector<Stack<T>> m_full;
+    Stack<T> m_loose;
     mutable std::mutex m_mutex;
+    std::condition_variable m_returned;
+
+    // Loose nodes which are still counted as available, but which are out
+    // of the free list while another acquirer cuts them.
+    std::size_t m_lent;
 
+    std::size_t m_available;
     std::size_t m_allocated;
 };
 
@@ -927,54 +1545,376 @@ private:
     mutable std::mutex m_mutex;
 };
 
+namespace zero
+{
+
+// Ranges at least this large are zeroed with non-temporal stores, so that
+// zeroing them does not evict the working set from the cache.
+const std::size_t streamThreshold(16384);
+
+// Ranges at least this large have their interior pages handed back to the
+// kernel, which maps in fresh zero pages upon their next use.
+const std::size_t discardThreshold(262144);
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+
+__attribute__((target("avx512f")))
+inline void stream512(char* p, std::size_t n)
+{
+    const __m512i z(_mm512_setzero_si512());
+    for (std::size_t i(0); i < n; i += 64)
+    {
+        _mm512_stream_si512(reinterpret_cast<__m512i*>(p + i), z);
+    }
+}
+
+__attribute__((target("avx2")))
+inline void stream256(char* p, std::size_t n)
+{
+    const __m256i z(_mm256_setzero_si256());
+    for (std::size_t i(0); i < n; i += 32)
+    {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(p + i), z);
+    }
+}
+
+inline void stream128(char* p, std::size_t n)
+{
+    const __m128i z(_mm_setzero_si128());
+    for (std::size_t i(0); i < n; i += 16)
+    {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(p + i), z);
+    }
+}
+
+// 2 for AVX-512, 1 for AVX2, and 0 for the SSE2 baseline of x86-64.
+inline int level()
+{
+    static const int level([]()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return 2;
+        if (__builtin_cpu_supports("avx2")) return 1;
+        return 0;
+    }());
+
+    return level;
+}
+
+// Zero a range with non-temporal stores, selecting the widest instruction
+// set supported at runtime.
+inline void stream(void* dst, std::size_t n)
+{
+    char* p(static_cast<char*>(dst));
+
+    const std::size_t misalignment(reinterpret_cast<std::uintptr_t>(p) % 64);
+    const std::size_t head(std::min(n, misalignment ? 64 - misalignment : 0));
+
+    std::memset(p, 0, head);
+    p += head;
+    n -= head;
+
+    const std::size_t body(n / 64 * 64);
+
+    switch (level())
+    {
+        case 2: stream512(p, body); break;
+        case 1: stream256(p, body); break;
+        default: stream128(p, body); break;
+    }
+
+    _mm_sfence();
+    std::memset(p + body, 0, n - body);
+}
+
+#else
+
+inline void stream(void* dst, std::size_t n) { std::memset(dst, 0, n); }
+
+#endif
+
+// Hand the whole pages within this range back to the kernel, zeroing the
+// partial pages at either end.  Only valid for private anonymous memory.
+// Returns false, having done nothing, if this is not possible.
+inline bool discard(void* dst, std::size_t n)
+{
+#if defined(__linux__)
+    static const std::uintptr_t page(sysconf(_SC_PAGESIZE));
+
+    const std::uintptr_t begin(reinterpret_cast<std::uintptr_t>(dst));
+    const std::uintptr_t end(begin + n);
+    const std::uintptr_t pageBegin((begin + page - 1) / page * page);
+    const std::uintptr_t pageEnd(end / page * page);
+
+    if (pageEnd <= pageBegin || pageEnd - pageBegin < discardThreshold)
+    {
+        return false;
+    }
+
+    void* pages(reinterpret_cast<void*>(pageBegin));
+    if (madvise(pages, pageEnd - pageBegin, MADV_DONTNEED)) return false;
+
+    stream(dst, pageBegin - begin);
+    stream(reinterpret_cast<void*>(pageEnd), end - pageEnd);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Zero a range of bytes with whichever method is best suited to its size.
+inline void fill(void* dst, std::size_t n)
+{
+    if (n >= discardThreshold && discard(dst, n)) return;
+    else if (n >= streamThreshold) stream(dst, n);
+    else std::memset(dst, 0, n);
+}
+
+} // namespace zero
+
+// Determines when the buffers of a BufferPool are zeroed.
+enum class Zeroing
+{
+    // Each buffer is zeroed in full as it is released.
+    Release,
+
+    // Each buffer is zeroed as it is released, but only up to the length
+    // marked by BufferPool::dirty, if any, since its acquisition.
+    Dirty,
+
+    // Buffers are never zeroed implicitly, so releasing a Stack of them only
+    // splices pointers.  Use BufferPool::acquireZeroed to zero on demand.
+    Never
+};
+
 template<typename T>
 class BufferPool : public SplicePool<T*>
 {
 public:
-    BufferPool(std::size_t bufferSize, std::size_t blockSize = 4096)
+    using UniqueNodeType = typename SplicePool<T*>::UniqueNodeType;
+    using UniqueStackType = typename SplicePool<T*>::UniqueStackType;
+
+    // Each buffer starts on a multiple of alignment bytes, which must be a
+    // power of two and a multiple of sizeof(T).  Buffers are padded as
+    // needed to maintain this alignment, for example for O_DIRECT I/O or
+    // aligned SIMD loads.
+    BufferPool(
+            std::size_t bufferSize,
+            std::size_t blockSize = 4096,
+            Zeroing zeroing = Zeroing::Release,
+            std::size_t alignment = alignof(T))
         : SplicePool<T*>(blockSize)
         , m_bufferSize(bufferSize)
-        , m_bytesPerBlock(m_bufferSize * this->m_blockSize)
+        , m_alignment(alignment)
+        , m_stride(
+                (m_bufferSize * sizeof(T) + m_alignment - 1) /
+                m_alignment * m_alignment / sizeof(T))
+        , m_bytesPerBlock(m_stride * this->m_blockSize)
+        , m_zeroing(zeroing)
         , m_bytes()
         , m_nodes()
+        , m_dirty()
+        , m_index()
         , m_mutex()
     { }
 
+    std::size_t bufferSize() const { return m_bufferSize; }
+    std::size_t alignment() const { return m_alignment; }
+    Zeroing zeroing() const { return m_zeroing; }
+
+    // Acquire buffers which are guaranteed to be zeroed.  Under
+    // Zeroing::Never, this is where the zeroing occurs - otherwise released
+    // buffers are already clean.
+    UniqueNodeType acquireOneZeroed()
+    {
+        UniqueNodeType node(this->acquireOne());
+        if (m_zeroing == Zeroing::Never) zero(node.get()->val());
+        return node;
+    }
+
+    UniqueStackType acquireZeroed(std::size_t count)
+    {
+        Stack<T*> stack(this->acquire(count).release());
+        if (m_zeroing == Zeroing::Never) zero(stack);
+        return UniqueStackType(*this, std::move(stack));
+    }
+
+    // Under Zeroing::Dirty, marks the leading length elements of this buffer
+    // as the only ones which need to be zeroed when it is released.  Marks
+    // made while the buffer is held accumulate, so the longest one wins.
+    // Otherwise, this is a no-op.
+    void dirty(const T* buffer, std::size_t length)
+    {
+        if (m_zeroing != Zeroing::Dirty) return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::size_t block(0);
+        std::size_t index(0);
+
+        if (locate(buffer, block, index))
+        {
+            std::size_t& mark((*m_dirty[block])[index]);
+            length = std::min(length, m_bufferSize);
+            mark = mark == unmarked() ? length : std::max(mark, length);
+        }
+    }
+
+    void zero(T* buffer) const { zero(buffer, m_bufferSize); }
+
+    // Zero every buffer of a Stack.  Buffers which are adjacent in memory are
+    // coalesced so that each contiguous range is zeroed at once.
+    void zero(const Stack<T*>& stack) const
+    {
+        std::vector<T*> buffers;
+        buffers.reserve(stack.size());
+
+        for (T* buffer : stack) buffers.push_back(buffer);
+        std::sort(buffers.begin(), buffers.end(), std::less<T*>());
+
+        std::size_t i(0);
+
+        while (i < buffers.size())
+        {
+            T* begin(buffers[i]);
+            std::size_t count(1);
+
+            while (
+                    ++i < buffers.size() &&
+                    buffers[i] == begin + m_stride * count)
+            {
+                ++count;
+            }
+
+            zero(begin, m_stride * (count - 1) + m_bufferSize);
+        }
+    }
+
+    // Returns the address range of each block allocated so far, in order of
+    // address, as the first buffer of the block and its length in elements.
+    std::vector<std::pair<T*, std::size_t>> blocks() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<std::pair<T*, std::size_t>> result;
+        for (const auto& p : m_index)
+        {
+            result.emplace_back(const_cast<T*>(p.first), m_bytesPerBlock);
+        }
+
+        return result;
+    }
+
+    // Returns the node which owns this buffer, or nullptr if the buffer was
+    // not allocated by this pool.
+    //
+    // This operation has complexity O(log b), b being the number of
+    // allocated blocks.
+    Node<T*>* find(const T* buffer) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::size_t block(0);
+        std::size_t index(0);
+
+        if (!locate(buffer, block, index)) return nullptr;
+        return &(*m_nodes[block])[index];
+    }
+
 private:
+    // Extra elements allocated per block so that its first buffer may be
+    // aligned.
+    std::size_t padding() const
+    {
+        return m_alignment > alignof(T) ? m_alignment / sizeof(T) : 0;
+    }
+
+    // The first aligned element of a block.
+    T* aligned(std::vector<T>& bytes) const
+    {
+        const std::uintptr_t p(reinterpret_cast<std::uintptr_t>(bytes.data()));
+        const std::uintptr_t misalignment(p % m_alignment);
+        const std::uintptr_t offset(
+                misalignment ? m_alignment - misalignment : 0);
+
+        return bytes.data() + offset / sizeof(T);
+    }
+
+    // Must be called while holding m_mutex.
+    bool locate(const T* buffer, std::size_t& block, std::size_t& index) const
+    {
+        auto it(m_index.upper_bound(buffer));
+        if (it == m_index.begin()) return false;
+
+        --it;
+        const T* begin(it->first);
+
+        if (!std::less<const T*>()(buffer, begin + m_bytesPerBlock))
+        {
+            return false;
+        }
+
+        const std::size_t offset(buffer - begin);
+        if (offset % m_stride) return false;
+
+        block = it->second;
+        index = offset / m_stride;
+        return true;
+    }
+
     virtual Stack<T*> doAllocate(std::size_t blocks) override
     {
+        assert(m_alignment && !(m_alignment & (m_alignment - 1)));
+        assert(m_alignment % sizeof(T) == 0);
+
         Stack<T*> stack;
 
         std::deque<std::unique_ptr<std::vector<T>>> newBytes;
         std::deque<std::unique_ptr<std::vector<Node<T*>>>> newNodes;
+        std::deque<std::unique_ptr<std::vector<std::size_t>>> newDirty;
 
         for (std::size_t i(0); i < blocks; ++i)
         {
             std::unique_ptr<std::vector<T>> newByteBlock(
-                    new std::vector<T>(m_bytesPerBlock));
+                    new std::vector<T>(m_bytesPerBlock + padding()));
 
             std::unique_ptr<std::vector<Node<T*>>> newNodeBlock(
                     new std::vector<Node<T*>>(this->m_blockSize));
 
             newBytes.push_back(std::move(newByteBlock));
             newNodes.push_back(std::move(newNodeBlock));
+
+            if (m_zeroing == Zeroing::Dirty)
+            {
+                std::unique_ptr<std::vector<std::size_t>> newDirtyBlock(
+                        new std::vector<std::size_t>(
+                            this->m_blockSize,
+                            unmarked()));
+
+                newDirty.push_back(std::move(newDirtyBlock));
+            }
         }
 
         for (std::size_t i(0); i < blocks; ++i)
         {
-            std::vector<T>& bytes(*newBytes[i]);
+            T* bytes(aligned(*newBytes[i]));
             std::vector<Node<T*>>& nodes(*newNodes[i]);
 
             for (std::size_t i(0); i < this->m_blockSize; ++i)
             {
                 Node<T*>& node(nodes[i]);
-                node.val() = &bytes[m_bufferSize * i];
+                node.val() = bytes + m_stride * i;
                 stack.push(&node);
             }
         }
 
         std::lock_guard<std::mutex> lock(m_mutex);
 
+        for (std::size_t i(0); i < blocks; ++i)
+        {
+            m_index[aligned(*newBytes[i])] = m_bytes.size() + i;
+        }
+
         m_bytes.insert(
                 m_bytes.end(),
                 std::make_move_iterator(newBytes.begin()),
@@ -985,21 +1925,254 @@ private:
                 std::make_move_iterator(newNodes.begin()),
                 std::make_move_iterator(newNodes.end()));
 
+        m_dirty.insert(
+                m_dirty.end(),
+                std::make_move_iterator(newDirty.begin()),
+                std::make_move_iterator(newDirty.end()));
+
         return stack;
     }
 
     virtual void construct(T** val) const override
     {
-        std::fill(*val, *val + m_bufferSize, 0);
+        if (m_zeroing == Zeroing::Dirty)
+        {
+            std::size_t length(m_bufferSize);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                std::size_t block(0);
+                std::size_t index(0);
+
+                if (locate(*val, block, index))
+                {
+                    std::size_t& mark((*m_dirty[block])[index]);
+                    if (mark != unmarked()) length = mark;
+                    mark = unmarked();
+                }
+            }
+
+            zero(*val, length);
+        }
+        else
+        {
+            zero(*val);
+        }
+    }
+
+    virtual void reset(Stack<T*>& stack) override
+    {
+        if (m_zeroing == Zeroing::Dirty) SplicePool<T*>::reset(stack);
+        else zero(stack);
+    }
+
+    void zero(T* begin, std::size_t count) const
+    {
+        if (std::is_arithmetic<T>::value)
+        {
+            zero::fill(begin, count * sizeof(T));
+        }
+        else
+        {
+            std::fill(begin, begin + count, 0);
+        }
+    }
+
+    virtual bool resets() const override
+    {
+        return m_zeroing != Zeroing::Never;
     }
 
     const std::size_t m_bufferSize;
+    const std::size_t m_alignment;
+    const std::size_t m_stride;
     const std::size_t m_bytesPerBlock;
+    const Zeroing m_zeroing;
 
     std::deque<std::unique_ptr<std::vector<T>>> m_bytes;
     std::deque<std::unique_ptr<std::vector<Node<T*>>>> m_nodes;
+    // A buffer never marked dirty since its last release is zeroed in full.
+    static std::size_t unmarked() { return static_cast<std::size_t>(-1); }
+
+    std::deque<std::unique_ptr<std::vector<std::size_t>>> m_dirty;
+    std::map<const T*, std::size_t> m_index;
     mutable std::mutex m_mutex;
 };
 
+// A family of BufferPool instances at geometrically increasing sizes, for
+// buffers whose length varies.  Requests are served by the smallest class
+// that fits, and each class retains the batch splice semantics of a single
+// BufferPool.
+template<typename T>
+class SizeClassBufferPool
+{
+public:
+    using PoolType = BufferPool<T>;
+    using NodeType = typename PoolType::NodeType;
+    using UniqueNodeType = typename PoolType::UniqueNodeType;
+    using UniqueStackType = typename PoolType::UniqueStackType;
+
+    // Size classes start at minSize and grow by a factor of growth up to
+    // maxSize, which is always the largest class.  Each class allocates
+    // roughly blockBytes at a time.
+    SizeClassBufferPool(
+            std::size_t minSize,
+            std::size_t maxSize,
+            std::size_t growth = 2,
+            std::size_t blockBytes = 1 << 20,
+            Zeroing zeroing = Zeroing::Release,
+            std::size_t alignment = alignof(T))
+        : m_sizes()
+        , m_pools()
+    {
+        assert(minSize && minSize <= maxSize && growth > 1);
+
+        for (std::size_t size(minSize); size < maxSize; size *= growth)
+        {
+            m_sizes.push_back(size);
+        }
+
+        m_sizes.push_back(maxSize);
+
+        for (const std::size_t size : m_sizes)
+        {
+            const std::size_t blockSize(
+                    std::max<std::size_t>(blockBytes / size, 1));
+
+            m_pools.emplace_back(
+                    new PoolType(size, blockSize, zeroing, alignment));
+        }
+    }
+
+    std::size_t classes() const { return m_sizes.size(); }
+    std::size_t maxSize() const { return m_sizes.back(); }
+
+    // Returns the index of the smallest class that fits this length, or
+    // classes() if the length exceeds maxSize().
+    std::size_t classFor(std::size_t length) const
+    {
+        return std::lower_bound(m_sizes.begin(), m_sizes.end(), length) -
+            m_sizes.begin();
+    }
+
+    PoolType& pool(std::size_t index) { return *m_pools.at(index); }
+    const PoolType& pool(std::size_t index) const { return *m_pools.at(index); }
+
+    // Returns the pool for a length, throwing if no class is large enough.
+    PoolType& poolFor(std::size_t length)
+    {
+        const std::size_t index(classFor(length));
+
+        if (index == classes())
+        {
+            throw std::length_error("Buffer length exceeds largest class");
+        }
+
+        return *m_pools[index];
+    }
+
+    // Returns the pool which owns this buffer, or nullptr if there is none.
+    // This is a search over all classes, so callers who know the requested
+    // length of the buffer should prefer poolFor().
+    PoolType* find(const T* buffer)
+    {
+        for (auto& pool : m_pools)
+        {
+            if (pool->find(buffer)) return pool.get();
+        }
+
+        return nullptr;
+    }
+
+    UniqueNodeType acquireOne(std::size_t length)
+    {
+        return poolFor(length).acquireOne();
+    }
+
+    UniqueStackType acquire(std::size_t length, std::size_t count)
+    {
+        return poolFor(length).acquire(count);
+    }
+
+    // Release a buffer when its size class is known.  Throws
+    // std::invalid_argument if that class does not own the buffer.
+    void release(T* buffer, std::size_t length)
+    {
+        PoolType& pool(poolFor(length));
+        Node<T*>* node(pool.find(buffer));
+
+        if (!node) unowned();
+        pool.release(node);
+    }
+
+    // Release a buffer without knowledge of its size class.  Throws
+    // std::invalid_argument if no class owns the buffer.
+    void release(T* buffer)
+    {
+        for (auto& pool : m_pools)
+        {
+            if (Node<T*>* node = pool->find(buffer))
+            {
+                pool->release(node);
+                return;
+            }
+        }
+
+        unowned();
+    }
+
+    void release(Node<T*>* node) { if (node) release(node->val()); }
+
+    // Release a stack which may contain buffers of any class.  Buffers are
+    // grouped by class, and each group is spliced back into its pool at once.
+    //
+    // Buffers owned by no class are left in the stack, after every other
+    // buffer has been released, and std::invalid_argument is thrown.
+    void release(Stack<T*>&& stack)
+    {
+        // One extra group gathers the unowned buffers.
+        std::vector<Stack<T*>> groups(m_pools.size() + 1);
+
+        while (Node<T*>* node = stack.pop())
+        {
+            groups[classOf(node->val())].push(node);
+        }
+
+        for (std::size_t i(0); i < m_pools.size(); ++i)
+        {
+            if (!groups[i].empty()) m_pools[i]->release(std::move(groups[i]));
+        }
+
+        if (!groups.back().empty())
+        {
+            stack.push(groups.back());
+            unowned();
+        }
+    }
+
+private:
+    static void unowned()
+    {
+        throw std::invalid_argument("Buffer is not owned by this pool");
+    }
+
+    std::size_t classOf(const T* buffer) const
+    {
+        for (std::size_t i(0); i < m_pools.size(); ++i)
+        {
+            if (m_pools[i]->find(buffer)) return i;
+        }
+
+        return m_pools.size();
+    }
+
+    SizeClassBufferPool(const SizeClassBufferPool&) = delete;
+    SizeClassBufferPool& operator=(const SizeClassBufferPool&) = delete;
+
+    std::vector<std::size_t> m_sizes;
+    std::vector<std::unique_ptr<PoolType>> m_pools;
+};
+
 } // namespace splicer
 
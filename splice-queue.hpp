@@ -0,0 +1,378 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+template<typename T> class MpmcQueue;
+
+// Hint to the processor that this is a spin-wait loop.
+inline void cpuRelax()
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    _mm_pause();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// An intrusive multi-producer, single-consumer queue of pooled nodes, linked
+// through their own next pointers, so that neither enqueueing nor dequeueing
+// allocates.  Producers never block or retry: each push is a single atomic
+// exchange, and a whole Stack may be pushed at the cost of one node.
+//
+// Dequeued nodes are owned by the consumer, who may release them directly to
+// their pool.  Nodes must not be released while they are still queued.
+//
+// After Vyukov's intrusive MPSC queue.  A pop may briefly report the queue
+// as empty while a concurrent push is between its two steps.
+template<typename T>
+class MpscQueue
+{
+    friend class MpmcQueue<T>;
+
+public:
+    MpscQueue() : m_back(&m_stub), m_front(&m_stub), m_stub() { }
+
+    // Push to back.  May be called concurrently with any other calls.
+    void push(Node<T>* node)
+    {
+        assert(node);
+        link(node, node);
+    }
+
+    // Push every node of a Stack, in order, with a single exchange.
+    void push(Stack<T>&& stack)
+    {
+        if (stack.empty()) return;
+
+        Node<T>* head(stack.head());
+        Node<T>* tail(stack.tail());
+        stack = Stack<T>();
+
+        link(head, tail);
+    }
+
+    void push(UniqueNode<T>&& node) { push(node.release()); }
+    void push(UniqueStack<T>&& stack) { push(stack.release()); }
+
+    // Pop from front, or return null if the queue appears empty.  Only one
+    // thread may pop at a time.
+    Node<T>* pop()
+    {
+        Node<T>* front(m_front);
+        Node<T>* next(load(front));
+
+        if (front == &m_stub)
+        {
+            if (!next) return nullptr;
+
+            m_front = next;
+            front = next;
+            next = load(next);
+        }
+
+        if (next)
+        {
+            m_front = next;
+            return front;
+        }
+
+        // The front node is the last one linked, unless a producer has
+        // claimed the back but not yet linked to it.  In that case we must
+        // wait for it.
+        if (front != __atomic_load_n(&m_back, __ATOMIC_ACQUIRE)) return nullptr;
+
+        // Requeue the stub behind the front node so that it may be detached.
+        push(&m_stub);
+
+        next = load(front);
+        if (next)
+        {
+            m_front = next;
+            return front;
+        }
+
+        return nullptr;
+    }
+
+    // Pop a node, handing ownership to a UniqueNode of this pool.
+    UniqueNode<T> popOne(SplicePool<T>& pool)
+    {
+        return UniqueNode<T>(pool, pop());
+    }
+
+    // Pop up to count nodes, in order.  Only one thread may pop at a time.
+    Stack<T> popStack(std::size_t count)
+    {
+        Stack<T> stack;
+        Node<T>* node(nullptr);
+
+        while (stack.size() < count && (node = pop())) stack.pushBack(node);
+
+        return stack;
+    }
+
+    UniqueStack<T> popStack(SplicePool<T>& pool, std::size_t count)
+    {
+        return UniqueStack<T>(pool, popStack(count));
+    }
+
+    // Only the consumer may call this, and it is a hint only while producers
+    // are pushing.
+    bool empty() const
+    {
+        const Node<T>* front(m_front);
+        const Node<T>* next(__atomic_load_n(&front->m_next, __ATOMIC_ACQUIRE));
+
+        return front == &m_stub && !next;
+    }
+
+private:
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    static Node<T>* load(Node<T>* node)
+    {
+        return __atomic_load_n(&node->m_next, __ATOMIC_ACQUIRE);
+    }
+
+    // For an MpmcQueue, in place of pop(), with which it must not be mixed.
+    //
+    // Take every node pushed so far, in O(1), as the chain from first to
+    // last, or return false if there are none.  The stub is requeued behind
+    // them, and since nothing else requeues it, the stub is always the front.
+    // Links within the chain may still be being written by producers, so it
+    // must be walked with follow().
+    bool detach(Node<T>*& first, Node<T>*& last)
+    {
+        assert(m_front == &m_stub);
+
+        first = load(&m_stub);
+        if (!first) return false;
+
+        __atomic_store_n(&m_stub.m_next, nullptr, __ATOMIC_RELAXED);
+        last = __atomic_exchange_n(&m_back, &m_stub, __ATOMIC_ACQ_REL);
+        return true;
+    }
+
+    // The node after this one of a detached chain, waiting out any producer
+    // which has claimed the back of the queue but not yet linked to it.
+    static Node<T>* follow(Node<T>* node)
+    {
+        Node<T>* next(nullptr);
+        while (!(next = load(node))) cpuRelax();
+        return next;
+    }
+
+    // Cut up to count nodes from the front of a detached chain.  Afterward,
+    // first is the front of what remains of the chain, or null if nothing
+    // remains.
+    static Stack<T> cut(Node<T>*& first, Node<T>* last, std::size_t count)
+    {
+        if (!count || !first) return Stack<T>();
+
+        Node<T>* head(first);
+        Node<T>* tail(first);
+        std::size_t size(1);
+
+        while (size < count && tail != last)
+        {
+            tail = follow(tail);
+            ++size;
+        }
+
+        first = tail == last ? nullptr : follow(tail);
+        tail->setNext(nullptr);
+
+        return Stack<T>(head, tail, size);
+    }
+
+    // Link the last node of one detached chain to the first of another.
+    static void join(Node<T>* last, Node<T>* first) { last->setNext(first); }
+
+    void link(Node<T>* head, Node<T>* tail)
+    {
+        __atomic_store_n(&tail->m_next, nullptr, __ATOMIC_RELAXED);
+
+        Node<T>* prev(__atomic_exchange_n(&m_back, tail, __ATOMIC_ACQ_REL));
+        __atomic_store_n(&prev->m_next, head, __ATOMIC_RELEASE);
+    }
+
+    // Producers and the consumer work on separate cache lines.
+    alignas(64) Node<T>* m_back;
+    alignas(64) Node<T>* m_front;
+    Node<T> m_stub;
+};
+
+// A multi-producer, multi-consumer queue of pooled nodes.  Producers are as
+// cheap as those of an MpscQueue.  Consumers take turns behind a spinlock,
+// which is held only for a few instructions at a time: a consumer finding
+// nothing left over from earlier detaches every node queued so far in O(1),
+// and a pop takes the front of these.  A popStack() detaches everything, cuts
+// its batch after releasing the lock, and then returns the rest to the front,
+// so concurrent pops may be served newer nodes in the meantime.
+//
+// Serializing consumers means a dequeued node may be released to its pool, and
+// reused, immediately - a fully lock-free consumer side would need hazard
+// pointers or epochs to know when no other consumer could still be reading
+// from it.
+template<typename T>
+class MpmcQueue
+{
+public:
+    MpmcQueue() : m_queue(), m_first(nullptr), m_last(nullptr), m_lock(false)
+    { }
+
+    void push(Node<T>* node) { m_queue.push(node); }
+    void push(Stack<T>&& stack) { m_queue.push(std::move(stack)); }
+    void push(UniqueNode<T>&& node) { m_queue.push(std::move(node)); }
+    void push(UniqueStack<T>&& stack) { m_queue.push(std::move(stack)); }
+
+    Node<T>* pop()
+    {
+        Guard guard(m_lock);
+
+        if (!m_first && !m_queue.detach(m_first, m_last)) return nullptr;
+
+        Stack<T> stack(MpscQueue<T>::cut(m_first, m_last, 1));
+        return stack.pop();
+    }
+
+    UniqueNode<T> popOne(SplicePool<T>& pool)
+    {
+        return UniqueNode<T>(pool, pop());
+    }
+
+    // Pop up to count nodes, in order.  The batch is cut without holding the
+    // consumer lock.
+    Stack<T> popStack(std::size_t count)
+    {
+        if (!count) return Stack<T>();
+
+        Node<T>* first(nullptr);
+        Node<T>* last(nullptr);
+
+        {
+            Guard guard(m_lock);
+
+            // Anything queued since the last detach follows what was left.
+            if (m_queue.detach(first, last))
+            {
+                if (m_first) MpscQueue<T>::join(m_last, first);
+                else m_first = first;
+
+                m_last = last;
+            }
+
+            if (!m_first) return Stack<T>();
+
+            first = m_first;
+            last = m_last;
+            m_first = nullptr;
+            m_last = nullptr;
+        }
+
+        Stack<T> stack(MpscQueue<T>::cut(first, last, count));
+
+        if (first)
+        {
+            // The rest precedes anything detached in the meantime.
+            Guard guard(m_lock);
+
+            if (m_first) MpscQueue<T>::join(last, m_first);
+            else m_last = last;
+
+            m_first = first;
+        }
+
+        return stack;
+    }
+
+    UniqueStack<T> popStack(SplicePool<T>& pool, std::size_t count)
+    {
+        return UniqueStack<T>(pool, popStack(count));
+    }
+
+    // A hint only while other threads are pushing or popping.
+    bool empty() const
+    {
+        Guard guard(m_lock);
+        return !m_first && m_queue.empty();
+    }
+
+private:
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // Test-and-test-and-set, backing off exponentially with pause
+    // instructions while the lock is contended, then yielding the processor
+    // to whichever thread holds it.
+    class Guard
+    {
+    public:
+        explicit Guard(std::atomic<bool>& lock) : m_lock(lock)
+        {
+            std::size_t spins(1);
+
+            while (m_lock.exchange(true, std::memory_order_acquire))
+            {
+                while (m_lock.load(std::memory_order_relaxed))
+                {
+                    if (spins <= maxSpins)
+                    {
+                        for (std::size_t i(0); i < spins; ++i) cpuRelax();
+                        spins *= 2;
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }
+
+        ~Guard() { m_lock.store(false, std::memory_order_release); }
+
+    private:
+        static const std::size_t maxSpins = 64;
+
+        std::atomic<bool>& m_lock;
+    };
+
+    MpscQueue<T> m_queue;
+
+    // Detached nodes not yet popped, from first to last, guarded by m_lock.
+    Node<T>* m_first;
+    Node<T>* m_last;
+
+    alignas(64) mutable std::atomic<bool> m_lock;
+};
+
+} // namespace splicer
@@ -0,0 +1,127 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#if __cplusplus >= 201703L
+
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// A std::pmr::memory_resource which serves small allocations from a
+// SizeClassBufferPool with power-of-two size classes.  Requests larger than
+// the largest size class, or with an alignment stricter than that of
+// std::max_align_t, are forwarded to the upstream resource.
+//
+// Like any memory_resource, allocations are uninitialized, so recycled
+// buffers are not zeroed.
+class SplicePoolResource : public std::pmr::memory_resource
+{
+public:
+    explicit SplicePoolResource(
+            std::size_t minSize = 16,
+            std::size_t maxSize = 4096,
+            std::size_t blockBytes = 65536,
+            std::pmr::memory_resource* upstream =
+                std::pmr::get_default_resource())
+        : m_upstream(upstream)
+        , m_pool(
+                roundUp(minSize),
+                roundUp(std::max(minSize, maxSize)),
+                2,
+                blockBytes,
+                Zeroing::Never,
+                alignment())
+    { }
+
+    std::pmr::memory_resource* upstream() const { return m_upstream; }
+    std::size_t maxSize() const { return m_pool.maxSize(); }
+
+    // The alignment of every pooled buffer.  Stricter requests are never
+    // pooled, and go upstream instead.
+    static std::size_t alignment() { return alignof(std::max_align_t); }
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t align) override
+    {
+        if (pooled(bytes, align))
+        {
+            return m_pool.acquireOne(bytes).release()->val();
+        }
+
+        return m_upstream->allocate(bytes, align);
+    }
+
+    virtual void do_deallocate(
+            void* p,
+            std::size_t bytes,
+            std::size_t align) override
+    {
+        if (pooled(bytes, align))
+        {
+            // Deallocation must not throw, so unlike the release() of the
+            // pool, a buffer not owned by its size class - which means a
+            // mismatched size or resource - is asserted against and otherwise
+            // ignored.
+            auto& pool(m_pool.poolFor(bytes));
+            auto node(pool.find(static_cast<unsigned char*>(p)));
+
+            assert(node);
+            if (node) pool.release(node);
+        }
+        else
+        {
+            m_upstream->deallocate(p, bytes, align);
+        }
+    }
+
+    virtual bool do_is_equal(
+            const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    // Every size class is a multiple of the pool alignment, so that every
+    // buffer carved from an aligned block is itself aligned.
+    static std::size_t roundUp(std::size_t size)
+    {
+        const std::size_t align(alignment());
+        return std::max<std::size_t>((size + align - 1) / align * align, align);
+    }
+
+    bool pooled(std::size_t bytes, std::size_t align) const
+    {
+        return align <= alignment() && bytes <= maxSize();
+    }
+
+    std::pmr::memory_resource* const m_upstream;
+    SizeClassBufferPool<unsigned char> m_pool;
+};
+
+} // namespace splicer
+
+#endif
@@ -0,0 +1,563 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "splice-pool.hpp"
+#include "splice-queue.hpp"
+
+namespace splicer
+{
+
+// A type-erased nullary callable, stored inline if it is small enough so
+// that pooled tasks never allocate.  Larger callables fall back to the heap.
+class Task
+{
+public:
+    static const std::size_t inlineSize = 48;
+
+    Task() : m_storage(), m_run(nullptr), m_destroy(nullptr) { }
+    ~Task() { clear(); }
+
+    template<typename F>
+    void assign(F&& f)
+    {
+        using Fn = typename std::decay<F>::type;
+
+        clear();
+        emplace<Fn>(
+                std::forward<F>(f),
+                std::integral_constant<
+                    bool,
+                    sizeof(Fn) <= inlineSize &&
+                        alignof(Fn) <= alignof(Storage)>());
+    }
+
+    void operator()() { m_run(&m_storage); }
+
+    void clear()
+    {
+        if (m_destroy) m_destroy(&m_storage);
+        m_run = nullptr;
+        m_destroy = nullptr;
+    }
+
+    explicit operator bool() const { return m_run != nullptr; }
+
+private:
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    using Storage =
+        typename std::aligned_storage<inlineSize, alignof(void*) * 2>::type;
+
+    // Chosen at compile time, so that the inline placement is never
+    // instantiated for callables which do not fit.
+    template<typename Fn, typename F>
+    void emplace(F&& f, std::true_type)
+    {
+        new (&m_storage) Fn(std::forward<F>(f));
+        m_run = &runInline<Fn>;
+        m_destroy = &destroyInline<Fn>;
+    }
+
+    template<typename Fn, typename F>
+    void emplace(F&& f, std::false_type)
+    {
+        *reinterpret_cast<Fn**>(&m_storage) = new Fn(std::forward<F>(f));
+        m_run = &runHeap<Fn>;
+        m_destroy = &destroyHeap<Fn>;
+    }
+
+    template<typename Fn>
+    static void runInline(void* p) { (*static_cast<Fn*>(p))(); }
+
+    template<typename Fn>
+    static void destroyInline(void* p) { static_cast<Fn*>(p)->~Fn(); }
+
+    template<typename Fn>
+    static void runHeap(void* p) { (**static_cast<Fn**>(p))(); }
+
+    template<typename Fn>
+    static void destroyHeap(void* p) { delete *static_cast<Fn**>(p); }
+
+    Storage m_storage;
+    void (*m_run)(void*);
+    void (*m_destroy)(void*);
+};
+
+// A Chase-Lev work-stealing deque of nodes.  Only its owner may push and
+// take, at the bottom, while any thread may steal from the top.  Memory
+// orderings follow Le et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models".  Arrays outgrown by the deque are retained until it is
+// destroyed, since thieves may still be reading them.
+template<typename T>
+class StealingDeque
+{
+public:
+    explicit StealingDeque(std::size_t capacity = 1024)
+        : m_top(0)
+        , m_bottom(0)
+        , m_array(nullptr)
+        , m_arrays()
+    {
+        std::size_t size(1);
+        while (size < capacity) size *= 2;
+
+        m_arrays.emplace_back(new Array(size));
+        m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    // Owner only.
+    void push(Node<T>* node)
+    {
+        const std::int64_t b(m_bottom.load(std::memory_order_relaxed));
+        const std::int64_t t(m_top.load(std::memory_order_acquire));
+        Array* a(m_array.load(std::memory_order_relaxed));
+
+        if (b - t > static_cast<std::int64_t>(a->size()) - 1)
+        {
+            a = grow(a, b, t);
+        }
+
+        a->put(b, node);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only.  Returns the most recently pushed node, or null.
+    Node<T>* take()
+    {
+        const std::int64_t b(m_bottom.load(std::memory_order_relaxed) - 1);
+        Array* a(m_array.load(std::memory_order_relaxed));
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t(m_top.load(std::memory_order_relaxed));
+
+        Node<T>* node(nullptr);
+
+        if (t <= b)
+        {
+            node = a->get(b);
+
+            if (t == b)
+            {
+                // Last node - race any thieves for it.
+                if (!m_top.compare_exchange_strong(
+                            t,
+                            t + 1,
+                            std::memory_order_seq_cst,
+                            std::memory_order_relaxed))
+                {
+                    node = nullptr;
+                }
+
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return node;
+    }
+
+    // Any thread.  Returns the least recently pushed node, or null if the
+    // deque is empty or the steal lost a race.
+    Node<T>* steal()
+    {
+        std::int64_t t(m_top.load(std::memory_order_acquire));
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b(m_bottom.load(std::memory_order_acquire));
+
+        if (t < b)
+        {
+            Array* a(m_array.load(std::memory_order_acquire));
+            Node<T>* node(a->get(t));
+
+            if (m_top.compare_exchange_strong(
+                        t,
+                        t + 1,
+                        std::memory_order_seq_cst,
+                        std::memory_order_relaxed))
+            {
+                return node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // A hint only, if other threads are working on the deque.
+    bool empty() const
+    {
+        return m_bottom.load(std::memory_order_acquire) <=
+            m_top.load(std::memory_order_acquire);
+    }
+
+private:
+    StealingDeque(const StealingDeque&) = delete;
+    StealingDeque& operator=(const StealingDeque&) = delete;
+
+    class Array
+    {
+    public:
+        explicit Array(std::size_t size)
+            : m_mask(size - 1)
+            , m_nodes(new std::atomic<Node<T>*>[size])
+        { }
+
+        std::size_t size() const { return m_mask + 1; }
+
+        Node<T>* get(std::int64_t i) const
+        {
+            return m_nodes[i & m_mask].load(std::memory_order_relaxed);
+        }
+
+        void put(std::int64_t i, Node<T>* node)
+        {
+            m_nodes[i & m_mask].store(node, std::memory_order_relaxed);
+        }
+
+    private:
+        const std::size_t m_mask;
+        std::unique_ptr<std::atomic<Node<T>*>[]> m_nodes;
+    };
+
+    Array* grow(Array* a, std::int64_t b, std::int64_t t)
+    {
+        m_arrays.emplace_back(new Array(a->size() * 2));
+        Array* grown(m_arrays.back().get());
+
+        for (std::int64_t i(t); i < b; ++i) grown->put(i, a->get(i));
+
+        m_array.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<std::int64_t> m_top;
+    alignas(64) std::atomic<std::int64_t> m_bottom;
+    std::atomic<Array*> m_array;
+
+    // Owned by the owner thread.
+    std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
+// A work-stealing executor whose tasks are pooled nodes.  Each worker owns
+// a StealingDeque, and idle workers steal from the others.  Task nodes are
+// drawn from a cache local to each worker, which is refilled from and
+// drained to the shared ObjectPool a batch at a time, so spawning a task
+// from within another task touches no locks and never allocates, provided
+// its callable fits inline.
+//
+// Tasks spawned from outside the workers go through an injection queue.  The
+// first exception thrown by a task is rethrown from wait().
+class Scheduler
+{
+public:
+    using Pool = ObjectPool<Task>;
+
+    explicit Scheduler(
+            std::size_t threads = std::thread::hardware_concurrency(),
+            std::size_t batchSize = 64)
+        : m_batchSize(std::max<std::size_t>(batchSize, 1))
+        , m_pool(4096)
+        , m_injected()
+        , m_workers()
+        , m_pending(0)
+        , m_sleeping(0)
+        , m_stop(false)
+        , m_mutex()
+        , m_wake()
+        , m_done()
+        , m_error()
+    {
+        threads = std::max<std::size_t>(threads, 1);
+
+        for (std::size_t i(0); i < threads; ++i)
+        {
+            m_workers.emplace_back(new Worker(i));
+        }
+
+        for (auto& worker : m_workers)
+        {
+            Worker* w(worker.get());
+            w->thread = std::thread([this, w]() { work(*w); });
+        }
+    }
+
+    ~Scheduler()
+    {
+        try { wait(); } catch (...) { }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_wake.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            worker->thread.join();
+            m_pool.release(std::move(worker->cache));
+        }
+    }
+
+    // Run f on some worker.  When called from a worker of this scheduler,
+    // the task is pushed to the deque of that worker.
+    template<typename F>
+    void spawn(F&& f)
+    {
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        Worker* worker(current());
+
+        if (worker)
+        {
+            Node<Task>* node(acquire(*worker));
+            node->val().assign(std::forward<F>(f));
+            worker->deque.push(node);
+        }
+        else
+        {
+            Pool::UniqueNodeType node(m_pool.acquireOne());
+            node->assign(std::forward<F>(f));
+            m_injected.push(std::move(node));
+        }
+
+        notify();
+    }
+
+    // Block until every spawned task, including those spawned by other
+    // tasks, has completed.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return !m_pending.load(); });
+
+        if (m_error)
+        {
+            std::exception_ptr error(m_error);
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::size_t threads() const { return m_workers.size(); }
+    const Pool& pool() const { return m_pool; }
+
+private:
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    struct Worker
+    {
+        explicit Worker(std::size_t index)
+            : index(index)
+            , seed(static_cast<std::uint32_t>(index * 2654435761u + 1))
+            , deque()
+            , cache()
+            , thread()
+        { }
+
+        // The deque is padded against false sharing with alignas, which the
+        // global operator new of C++11 does not honor.
+        static void* operator new(std::size_t size)
+        {
+            void* p(nullptr);
+            if (::posix_memalign(&p, alignof(Worker), size))
+            {
+                throw std::bad_alloc();
+            }
+            return p;
+        }
+
+        static void operator delete(void* p) { std::free(p); }
+
+        const std::size_t index;
+        std::uint32_t seed;
+        StealingDeque<Task> deque;
+        Stack<Task> cache;
+        std::thread thread;
+    };
+
+    static Worker*& local()
+    {
+        static thread_local Worker* worker(nullptr);
+        return worker;
+    }
+
+    static Scheduler*& owner()
+    {
+        static thread_local Scheduler* scheduler(nullptr);
+        return scheduler;
+    }
+
+    Worker* current() const { return owner() == this ? local() : nullptr; }
+
+    Node<Task>* acquire(Worker& worker)
+    {
+        if (worker.cache.empty())
+        {
+            worker.cache = m_pool.acquire(m_batchSize).release();
+        }
+
+        return worker.cache.pop();
+    }
+
+    void recycle(Worker& worker, Node<Task>* node)
+    {
+        node->val().clear();
+        worker.cache.push(node);
+
+        if (worker.cache.size() >= m_batchSize * 2)
+        {
+            m_pool.release(worker.cache.popStack(m_batchSize));
+        }
+    }
+
+    Node<Task>* find(Worker& worker)
+    {
+        if (Node<Task>* node = worker.deque.take()) return node;
+        if (Node<Task>* node = m_injected.pop()) return node;
+
+        const std::size_t count(m_workers.size());
+
+        for (std::size_t attempt(0); attempt < count * 2; ++attempt)
+        {
+            worker.seed ^= worker.seed << 13;
+            worker.seed ^= worker.seed >> 17;
+            worker.seed ^= worker.seed << 5;
+
+            Worker& victim(*m_workers[worker.seed % count]);
+            if (&victim == &worker) continue;
+
+            if (Node<Task>* node = victim.deque.steal()) return node;
+        }
+
+        return nullptr;
+    }
+
+    bool idle() const
+    {
+        if (!m_injected.empty()) return false;
+
+        for (const auto& worker : m_workers)
+        {
+            if (!worker->deque.empty()) return false;
+        }
+
+        return true;
+    }
+
+    // Paired with the check of idle() by a worker about to sleep: either the
+    // worker sees the new task, or we see that it is sleeping.
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_sleeping.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wake.notify_one();
+        }
+    }
+
+    void work(Worker& worker)
+    {
+        local() = &worker;
+        owner() = this;
+
+        while (true)
+        {
+            if (Node<Task>* node = find(worker))
+            {
+                run(worker, node);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_sleeping.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            m_wake.wait(lock, [this]() { return m_stop || !idle(); });
+
+            m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+            if (m_stop) break;
+        }
+    }
+
+    void run(Worker& worker, Node<Task>* node)
+    {
+        try
+        {
+            node->val()();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) m_error = std::current_exception();
+        }
+
+        recycle(worker, node);
+
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+
+    const std::size_t m_batchSize;
+
+    Pool m_pool;
+    MpmcQueue<Task> m_injected;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    std::atomic<std::size_t> m_pending;
+    std::atomic<std::size_t> m_sleeping;
+    bool m_stop;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::exception_ptr m_error;
+};
+
+} // namespace splicer
@@ -0,0 +1,453 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+// An object pool whose nodes live in shared memory, so that one process may
+// acquire a Stack, fill it, and hand it to another process without copying.
+// The receiving process takes ownership of the nodes, and releases them to
+// its own instance of the same pool.
+//
+// Nodes are carved from the shared region a block at a time, and each
+// process keeps a local free list as with any other pool, so the shared
+// lock is taken only once per block.  Available nodes are returned to the
+// shared free list by flush() and upon destruction.
+//
+// Links between nodes are native pointers, so every process must map the
+// region at the same address.  The creating process records its address,
+// and others fail to open the pool if that address is not free.  Opening
+// the pool before any other large mappings are made, or in a process forked
+// before the pool was created, is usually enough.
+//
+// A process-shared robust mutex guards the shared free list.  If a process
+// dies while holding it, the lock is recovered, but the free list is not
+// repaired.  T must be trivially copyable.
+template<typename T>
+class SharedPool : public SplicePool<T>
+{
+    static_assert(
+            std::is_trivially_copyable<T>::value,
+            "Shared types must be trivially copyable");
+
+public:
+    using UniqueStackType = typename SplicePool<T>::UniqueStackType;
+
+    // A Stack in transit between processes, which may be written to a pipe
+    // or socket as is.
+    struct Handle
+    {
+        std::uint64_t head;
+        std::uint64_t tail;
+        std::uint64_t size;
+    };
+
+    // Open the shared memory object with this name, or create it with room
+    // for capacity nodes (rounded up to a whole number of blocks) if it does
+    // not exist.
+    SharedPool(
+            const std::string& name,
+            std::size_t capacity,
+            std::size_t blockSize = 4096)
+        : SplicePool<T>(blockSize)
+        , m_fd(-1)
+        , m_size(0)
+        , m_data(nullptr)
+    {
+        bool created(true);
+
+        m_fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+
+        if (m_fd < 0 && errno == EEXIST)
+        {
+            created = false;
+            m_fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+        }
+
+        if (m_fd < 0) fail("Could not open " + name);
+
+        init(created, capacity);
+    }
+
+    // Use a descriptor, for example from memfd_create, which is shared with
+    // other processes by inheritance or over a socket.  The region is created
+    // if the file is empty.  The descriptor is duplicated, so the caller
+    // retains ownership of it.
+    SharedPool(int fd, std::size_t capacity, std::size_t blockSize = 4096)
+        : SplicePool<T>(blockSize)
+        , m_fd(::dup(fd))
+        , m_size(0)
+        , m_data(nullptr)
+    {
+        if (m_fd < 0) fail("Could not duplicate shared pool descriptor");
+
+        struct stat st;
+        if (::fstat(m_fd, &st)) fail("Could not stat shared pool");
+
+        init(!st.st_size, capacity);
+    }
+
+    ~SharedPool()
+    {
+        if (m_data) flush();
+        unmap();
+    }
+
+    // Remove a named pool.  Processes which have it open are unaffected.
+    static void unlink(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+    std::size_t capacity() const { return header().capacity; }
+
+    const void* data() const { return m_data; }
+
+    // The number of nodes in the shared free list, which does not include
+    // those available locally in any process.
+    std::size_t shared() const
+    {
+        Lock lock(const_cast<Header&>(header()));
+        return header().size;
+    }
+
+    // Return the locally available nodes to the shared free list, so that
+    // other processes may acquire them.
+    void flush()
+    {
+        Stack<T> available(this->surrender());
+        if (available.empty()) return;
+
+        Lock lock(header());
+
+        Stack<T> free(load());
+        free.push(available);
+        store(free);
+    }
+
+    // Give up ownership of a stack so that it may be received by another
+    // process with receive().
+    Handle send(Stack<T>&& stack)
+    {
+        Handle handle;
+        handle.head = offset(stack.head());
+        handle.tail = offset(stack.tail());
+        handle.size = stack.size();
+
+        this->disown(stack.size());
+        stack = Stack<T>();
+
+        return handle;
+    }
+
+    Handle send(UniqueStackType&& stack) { return send(stack.release()); }
+
+    // Take ownership of a stack sent by another process.
+    UniqueStackType receive(const Handle& handle)
+    {
+        Stack<T> stack(pointer(handle.head), pointer(handle.tail), handle.size);
+        this->adopt(Stack<T>(), handle.size);
+        return UniqueStackType(*this, std::move(stack));
+    }
+
+private:
+    struct Header
+    {
+        std::uint64_t magic;
+        std::uint64_t nodeSize;
+        std::uint64_t capacity;
+        std::uint64_t carved;
+        std::uint64_t base;
+        std::uint32_t ready;
+
+        pthread_mutex_t mutex;
+
+        // Shared free list.
+        std::uint64_t head;
+        std::uint64_t tail;
+        std::uint64_t size;
+    };
+
+    class Lock
+    {
+    public:
+        explicit Lock(Header& header) : m_mutex(header.mutex)
+        {
+            const int err(::pthread_mutex_lock(&m_mutex));
+
+            if (err == EOWNERDEAD) ::pthread_mutex_consistent(&m_mutex);
+            else if (err)
+            {
+                throw std::system_error(
+                        err,
+                        std::generic_category(),
+                        "Could not lock shared pool");
+            }
+        }
+
+        ~Lock() { ::pthread_mutex_unlock(&m_mutex); }
+
+    private:
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+        pthread_mutex_t& m_mutex;
+    };
+
+    static std::uint64_t magicNumber() { return 0x73706c6963657232ull; }
+
+    static std::size_t nodesOffset()
+    {
+        const std::size_t align(
+                alignof(Node<T>) > 64 ? alignof(Node<T>) : 64);
+        return (sizeof(Header) + align - 1) / align * align;
+    }
+
+    static void fail(const std::string& message)
+    {
+        throw std::system_error(errno, std::generic_category(), message);
+    }
+
+    Header& header() { return *static_cast<Header*>(m_data); }
+    const Header& header() const { return *static_cast<const Header*>(m_data); }
+
+    Node<T>* nodes()
+    {
+        return reinterpret_cast<Node<T>*>(
+                static_cast<char*>(m_data) + nodesOffset());
+    }
+
+    // Offsets are relative to the start of the region, where the header
+    // lives, so zero is never a valid node offset and represents null.
+    std::uint64_t offset(const Node<T>* node) const
+    {
+        if (!node) return 0;
+        return reinterpret_cast<const char*>(node) -
+            static_cast<const char*>(m_data);
+    }
+
+    Node<T>* pointer(std::uint64_t offset)
+    {
+        if (!offset) return nullptr;
+        return reinterpret_cast<Node<T>*>(static_cast<char*>(m_data) + offset);
+    }
+
+    // Must be called while holding the shared lock.
+    Stack<T> load()
+    {
+        const Header& h(header());
+        return Stack<T>(pointer(h.head), pointer(h.tail), h.size);
+    }
+
+    // Must be called while holding the shared lock.
+    void store(const Stack<T>& stack)
+    {
+        Header& h(header());
+        h.head = offset(stack.head());
+        h.tail = offset(stack.tail());
+        h.size = stack.size();
+    }
+
+    void init(bool create, std::size_t capacity)
+    {
+        try
+        {
+            if (create)
+            {
+                const std::size_t blockSize(this->m_blockSize);
+                capacity = (capacity + blockSize - 1) / blockSize * blockSize;
+                initialize(capacity);
+            }
+            else
+            {
+                open();
+            }
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+    }
+
+    void map(std::size_t size, void* hint)
+    {
+        m_size = size;
+        m_data = ::mmap(
+                hint,
+                m_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                m_fd,
+                0);
+
+        if (m_data == MAP_FAILED)
+        {
+            m_data = nullptr;
+            fail("Could not map shared pool");
+        }
+    }
+
+    void unmap()
+    {
+        if (m_data) ::munmap(m_data, m_size);
+        if (m_fd >= 0) ::close(m_fd);
+
+        m_data = nullptr;
+        m_fd = -1;
+    }
+
+    void initialize(std::size_t capacity)
+    {
+        const std::size_t size(nodesOffset() + capacity * sizeof(Node<T>));
+        if (::ftruncate(m_fd, size)) fail("Could not size shared pool");
+
+        map(size, nullptr);
+
+        Header& h(header());
+        h.magic = magicNumber();
+        h.nodeSize = sizeof(Node<T>);
+        h.capacity = capacity;
+        h.carved = 0;
+        h.base = reinterpret_cast<std::uintptr_t>(m_data);
+        h.head = 0;
+        h.tail = 0;
+        h.size = 0;
+
+        pthread_mutexattr_t attr;
+        ::pthread_mutexattr_init(&attr);
+        ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        const int err(::pthread_mutex_init(&h.mutex, &attr));
+        ::pthread_mutexattr_destroy(&attr);
+
+        if (err)
+        {
+            throw std::system_error(
+                    err,
+                    std::generic_category(),
+                    "Could not initialize shared pool lock");
+        }
+
+        __atomic_store_n(&h.ready, 1, __ATOMIC_RELEASE);
+    }
+
+    void open()
+    {
+        // The creating process may not have sized or initialized the region
+        // yet.
+        struct stat st;
+        do
+        {
+            if (::fstat(m_fd, &st)) fail("Could not stat shared pool");
+            if (!st.st_size) ::sched_yield();
+        }
+        while (!st.st_size);
+
+        if (static_cast<std::size_t>(st.st_size) < sizeof(Header))
+        {
+            throw std::runtime_error("Invalid shared pool");
+        }
+
+        // Map the header alone to find the address of the region.
+        map(sizeof(Header), nullptr);
+
+        while (!__atomic_load_n(&header().ready, __ATOMIC_ACQUIRE))
+        {
+            ::sched_yield();
+        }
+
+        const Header h(header());
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+
+        if (h.magic != magicNumber() ||
+                h.nodeSize != sizeof(Node<T>) ||
+                static_cast<std::size_t>(st.st_size) <
+                    nodesOffset() + h.capacity * sizeof(Node<T>))
+        {
+            throw std::runtime_error("Invalid shared pool");
+        }
+
+        void* base(reinterpret_cast<void*>(h.base));
+        map(st.st_size, base);
+
+        if (m_data != base)
+        {
+            throw std::runtime_error(
+                    "Shared pool could not be mapped at its base address");
+        }
+    }
+
+    virtual Stack<T> doAllocate(std::size_t blocks) override
+    {
+        const std::size_t count(blocks * this->m_blockSize);
+
+        Lock lock(header());
+        Header& h(header());
+
+        if (h.size + h.capacity - h.carved < count) throw std::bad_alloc();
+
+        Stack<T> free(load());
+        Stack<T> stack(free.popStack(count));
+        store(free);
+
+        const std::size_t carving(count - stack.size());
+        Node<T>* begin(nodes() + h.carved);
+
+        for (std::size_t i(0); i < carving; ++i)
+        {
+            stack.push(new (begin + i) Node<T>());
+        }
+
+        h.carved += carving;
+
+        return stack;
+    }
+
+    virtual void construct(T* val) const override
+    {
+        new (val) T();
+    }
+
+    int m_fd;
+    std::size_t m_size;
+    void* m_data;
+};
+
+} // namespace splicer
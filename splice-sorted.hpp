@@ -0,0 +1,295 @@
+/******************************************************************************
+    Copyright (c) 2016 Connor Manning
+
+    Permission is hereby granted, free of charge, to any person obtaining a
+    copy of this software and associated documentation files (the "Software"),
+    to deal in the Software without restriction, including without limitation
+    the rights to use, copy, modify, merge, publish, distribute, sublicense,
+    and/or sell copies of the Software, and to permit persons to whom the
+    Software is furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+******************************************************************************/
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "splice-pool.hpp"
+
+namespace splicer
+{
+
+template<typename T>
+struct SkipIndex
+{
+    SkipIndex() : target(nullptr), down(nullptr) { }
+
+    Node<T>* target;
+    Node<SkipIndex>* down;
+};
+
+// A sorted Stack with a skip-list index over its chain, giving O(log n)
+// expected insertion, search, and erasure.  The chain itself remains a plain
+// Stack, which may be released in O(1), and each level of the index is a
+// Stack of nodes from a pool of SkipIndex entries, so the index is also
+// released a level at a time.
+//
+// Like a Stack, this does not own its nodes: release() hands them back to
+// the caller.  Nodes with equal keys are kept in insertion order.
+template<typename T, typename Compare = std::less<T>>
+class SortedStack
+{
+public:
+    using Index = SkipIndex<T>;
+    using IndexPool = ObjectPool<Index>;
+
+    static const std::size_t maxLevels = 32;
+
+    explicit SortedStack(IndexPool& indexPool, Compare compare = Compare())
+        : m_indexPool(indexPool)
+        , m_compare(compare)
+        , m_stack()
+        , m_levels()
+        , m_seed(0x9e3779b9u)
+        , m_depth(0)
+    { }
+
+    ~SortedStack() { clearIndex(); }
+
+    std::size_t size() const { return m_stack.size(); }
+    bool empty() const { return m_stack.empty(); }
+    std::size_t levels() const { return m_levels.size(); }
+
+    const Stack<T>& stack() const { return m_stack; }
+
+    // Insert after any nodes with equal keys.
+    void insert(Node<T>* node)
+    {
+        const T& val(**node);
+        Node<Index>* update[maxLevels];
+
+        Node<T>* before(descend(NotGreater{m_compare, val}, update));
+
+        m_stack.pushAfter(before, node);
+
+        const std::size_t height(randomHeight());
+        while (m_levels.size() < height) m_levels.emplace_back();
+
+        Node<Index>* down(nullptr);
+
+        for (std::size_t i(0); i < height; ++i)
+        {
+            Node<Index>* index(m_indexPool.acquireOne().release());
+            index->val().target = node;
+            index->val().down = down;
+
+            m_levels[i].pushAfter(i < m_depth ? update[i] : nullptr, index);
+            down = index;
+        }
+    }
+
+    void insert(Stack<T>&& stack)
+    {
+        while (Node<T>* node = stack.pop()) insert(node);
+    }
+
+    // The first node not less than val, or null.
+    Node<T>* lowerBound(const T& val)
+    {
+        Node<T>* before(descend(Less{m_compare, val}));
+        return before ? before->next() : m_stack.head();
+    }
+
+    // The first node greater than val, or null.
+    Node<T>* upperBound(const T& val)
+    {
+        Node<T>* before(descend(NotGreater{m_compare, val}));
+        return before ? before->next() : m_stack.head();
+    }
+
+    // The first node equal to val, or null.
+    Node<T>* find(const T& val)
+    {
+        Node<T>* node(lowerBound(val));
+        return node && !m_compare(val, **node) ? node : nullptr;
+    }
+
+    // Remove a node, which must belong to this stack, and return it.
+    Node<T>* erase(Node<T>* node)
+    {
+        const T& val(**node);
+        Node<Index>* update[maxLevels];
+
+        Node<T>* before(descend(Less{m_compare, val}, update));
+
+        for (std::size_t i(0); i < m_depth; ++i)
+        {
+            Stack<Index>& level(m_levels[i]);
+            Node<Index>* prev(update[i]);
+            Node<Index>* next(prev ? prev->next() : level.head());
+
+            // Step over index entries of other nodes with equal keys.
+            while (next &&
+                    next->val().target != node &&
+                    !m_compare(val, **next->val().target))
+            {
+                prev = next;
+                next = next->next();
+            }
+
+            if (!next || next->val().target != node) break;
+
+            m_indexPool.release(level.popAfter(prev));
+        }
+
+        while (!m_levels.empty() && m_levels.back().empty())
+        {
+            m_levels.pop_back();
+        }
+
+        Node<T>* next(before ? before->next() : m_stack.head());
+        while (next != node)
+        {
+            assert(next);
+            before = next;
+            next = next->next();
+        }
+
+        return m_stack.popAfter(before);
+    }
+
+    // Remove the first node equal to val, returning it, or null.
+    Node<T>* erase(const T& val)
+    {
+        Node<T>* node(find(val));
+        return node ? erase(node) : nullptr;
+    }
+
+    Node<T>* pop() { return empty() ? nullptr : erase(m_stack.head()); }
+
+    // Give up every node as a plain sorted Stack, and release the index.
+    Stack<T> release()
+    {
+        clearIndex();
+
+        Stack<T> stack(m_stack);
+        m_stack = Stack<T>();
+        return stack;
+    }
+
+private:
+    SortedStack(const SortedStack&) = delete;
+    SortedStack& operator=(const SortedStack&) = delete;
+
+    // Passes values less than val.
+    struct Less
+    {
+        bool operator()(const T& v) const { return compare(v, val); }
+
+        const Compare& compare;
+        const T& val;
+    };
+
+    // Passes values not greater than val.
+    struct NotGreater
+    {
+        bool operator()(const T& v) const { return !compare(val, v); }
+
+        const Compare& compare;
+        const T& val;
+    };
+
+    // Walk down the index, and then the chain, passing nodes for which
+    // before(value) is true.  Returns the last such node of the chain, or
+    // null, and the last such index entry of each level in update.
+    template<typename Before>
+    Node<T>* descend(Before before, Node<Index>** update = nullptr)
+    {
+        Node<Index>* prev(nullptr);
+        m_depth = m_levels.size();
+
+        for (std::size_t i(m_levels.size()); i-- > 0; )
+        {
+            Node<Index>* next(prev ? prev->next() : m_levels[i].head());
+
+            while (next && before(**next->val().target))
+            {
+                prev = next;
+                next = next->next();
+            }
+
+            if (update) update[i] = prev;
+            if (i && prev) prev = prev->val().down;
+        }
+
+        Node<T>* node(prev ? prev->val().target : nullptr);
+        Node<T>* next(node ? node->next() : m_stack.head());
+
+        while (next && before(**next))
+        {
+            node = next;
+            next = next->next();
+        }
+
+        return node;
+    }
+
+    // Geometric with p = 1/4, so the index holds about n / 3 entries.
+    std::size_t randomHeight()
+    {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+
+        std::uint32_t bits(m_seed);
+        std::size_t height(0);
+
+        while ((bits & 3) == 0 && height < maxLevels - 1)
+        {
+            ++height;
+            bits >>= 2;
+            if (!bits) break;
+        }
+
+        return height;
+    }
+
+    void clearIndex()
+    {
+        for (Stack<Index>& level : m_levels)
+        {
+            m_indexPool.release(std::move(level));
+        }
+
+        m_levels.clear();
+    }
+
+    IndexPool& m_indexPool;
+    Compare m_compare;
+
+    Stack<T> m_stack;
+    std::vector<Stack<Index>> m_levels;
+
+    std::uint32_t m_seed;
+
+    // The number of levels at the time of the last descent.
+    std::size_t m_depth;
+};
+
+template<typename T, typename Compare>
+const std::size_t SortedStack<T, Compare>::maxLevels;
+
+} // namespace splicer
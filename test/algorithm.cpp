@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "splice-algorithm.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    // A key, and the input and position from which it came.
+    using Item = std::pair<int, std::size_t>;
+    using Nodes = std::vector<splicer::Node<Item>>;
+
+    bool byKey(const Item& a, const Item& b) { return a.first < b.first; }
+
+    // Build k sorted stacks of random lengths with many equal keys.
+    std::vector<splicer::Stack<Item>> makeRuns(
+            Nodes& nodes,
+            std::size_t k,
+            std::vector<Item>& expected)
+    {
+        std::mt19937 gen(k);
+        std::uniform_int_distribution<int> dist(0, 1000);
+
+        std::vector<splicer::Stack<Item>> runs(k);
+        std::vector<std::vector<int>> keys(k);
+
+        for (std::size_t i(0); i < nodes.size(); ++i)
+        {
+            keys[gen() % k].push_back(dist(gen));
+        }
+
+        std::size_t n(0);
+        for (std::size_t r(0); r < k; ++r)
+        {
+            std::sort(keys[r].begin(), keys[r].end());
+
+            for (const int key : keys[r])
+            {
+                *nodes[n] = Item(key, n);
+                expected.push_back(*nodes[n]);
+                runs[r].pushBack(&nodes[n++]);
+            }
+        }
+
+        // Stable by input, then position, which is the order built above.
+        std::stable_sort(expected.begin(), expected.end(), byKey);
+        return runs;
+    }
+}
+
+TEST(Algorithm, MergeAll)
+{
+    for (const std::size_t k : { 1, 2, 3, 7, 64, 300 })
+    {
+        for (const std::size_t threads : { 1, 4 })
+        {
+            Nodes nodes(20000);
+            std::vector<Item> expected;
+            std::vector<splicer::Stack<Item>> runs(
+                    makeRuns(nodes, k, expected));
+
+            splicer::Stack<Item> merged(
+                    splicer::mergeAll(runs, byKey, threads));
+
+            ASSERT_EQ(merged.size(), nodes.size());
+            for (const auto& run : runs) ASSERT_TRUE(run.empty());
+
+            std::size_t i(0);
+            for (const Item& item : merged) ASSERT_EQ(item, expected[i++]);
+            ASSERT_EQ(merged.tail()->val(), expected.back());
+        }
+    }
+}
+
+TEST(Algorithm, MergeAllEmpty)
+{
+    std::vector<splicer::Stack<Item>> none;
+    EXPECT_TRUE(splicer::mergeAll(none, byKey).empty());
+
+    std::vector<splicer::Stack<Item>> empties(5);
+    EXPECT_TRUE(splicer::mergeAll(empties, byKey, 2).empty());
+}
+
+TEST(Algorithm, MergeAllUnique)
+{
+    splicer::ObjectPool<int> pool(64);
+    std::vector<splicer::ObjectPool<int>::UniqueStackType> stacks;
+
+    for (int s(0); s < 10; ++s)
+    {
+        stacks.emplace_back(pool);
+        for (int i(s); i < 1000; i += 10)
+        {
+            stacks.back().pushBack(pool.acquireOne(i));
+        }
+    }
+
+    splicer::ObjectPool<int>::UniqueStackType merged(
+            splicer::mergeAll(pool, stacks, std::less<int>()));
+
+    ASSERT_EQ(merged.size(), 1000);
+
+    int i(0);
+    for (const int v : merged) ASSERT_EQ(v, i++);
+}
+
+TEST(Algorithm, ParallelSort)
+{
+    for (const std::size_t count : { 100, 50000, 300001 })
+    {
+        Nodes nodes(count);
+        splicer::Stack<Item> stack;
+
+        std::mt19937 gen(count);
+        std::uniform_int_distribution<int> dist(0, 5000);
+
+        for (std::size_t i(0); i < count; ++i)
+        {
+            *nodes[i] = Item(dist(gen), i);
+            stack.pushBack(&nodes[i]);
+        }
+
+        std::vector<Item> expected;
+        for (const Item& item : stack) expected.push_back(item);
+        std::stable_sort(expected.begin(), expected.end(), byKey);
+
+        splicer::parallelSort(stack, byKey, 4);
+
+        ASSERT_EQ(stack.size(), count);
+
+        std::size_t i(0);
+        for (const Item& item : stack) ASSERT_EQ(item, expected[i++]);
+        ASSERT_EQ(stack.tail()->val(), expected.back());
+    }
+}
+
+TEST(Algorithm, ParallelSortUnique)
+{
+    splicer::ObjectPool<int> pool(4096);
+    splicer::ObjectPool<int>::UniqueStackType stack(pool);
+
+    for (int i(0); i < 100000; ++i) stack.push(pool.acquireOne(i));
+
+    splicer::parallelSort(stack, std::less<int>(), 3);
+
+    ASSERT_EQ(stack.size(), 100000);
+
+    int i(0);
+    for (const int v : stack) ASSERT_EQ(v, i++);
+}
+
+TEST(Algorithm, RadixSort)
+{
+    using Keyed = std::pair<std::int64_t, std::size_t>;
+    const std::size_t count(100000);
+
+    std::vector<splicer::Node<Keyed>> nodes(count);
+    splicer::Stack<Keyed> stack;
+
+    std::mt19937_64 gen(7);
+
+    for (std::size_t i(0); i < count; ++i)
+    {
+        // Negative and positive keys, varying in every byte, with repeats.
+        std::int64_t key(static_cast<std::int64_t>(gen()));
+        if (i % 4 == 0) key = static_cast<std::int64_t>(i % 100) - 50;
+
+        *nodes[i] = Keyed(key, i);
+        stack.pushBack(&nodes[i]);
+    }
+
+    const auto byFirst([](const Keyed& a, const Keyed& b)
+    {
+        return a.first < b.first;
+    });
+
+    std::vector<Keyed> expected;
+    for (const Keyed& item : stack) expected.push_back(item);
+    std::stable_sort(expected.begin(), expected.end(), byFirst);
+
+    splicer::radixSort(stack, [](const Keyed& v) { return v.first; });
+
+    ASSERT_EQ(stack.size(), count);
+
+    std::size_t i(0);
+    for (const Keyed& item : stack) ASSERT_EQ(item, expected[i++]);
+    ASSERT_EQ(stack.tail()->val(), expected.back());
+}
+
+TEST(Algorithm, RadixSortNarrowKeys)
+{
+    splicer::ObjectPool<std::uint32_t> pool(4096);
+    splicer::ObjectPool<std::uint32_t>::UniqueStackType stack(pool);
+
+    // Only the low byte varies, so a single pass is needed.
+    for (std::uint32_t i(0); i < 1000; ++i)
+    {
+        stack.push(pool.acquireOne(0xabcd0000 | (i * 37 % 256)));
+    }
+
+    splicer::radixSort(stack, [](std::uint32_t v) { return v; });
+
+    EXPECT_EQ(stack.size(), 1000);
+    EXPECT_TRUE(stack.sortedBy(std::less<std::uint32_t>()));
+}
@@ -0,0 +1,100 @@
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "splice-allocator.hpp"
+#include "gtest/gtest.h"
+
+TEST(PoolAllocator, Rebind)
+{
+    using Alloc = splicer::PoolAllocator<int>;
+    using Rebound = std::allocator_traits<Alloc>::rebind_alloc<double>;
+
+    EXPECT_TRUE((std::is_same<Rebound, splicer::PoolAllocator<double>>::value));
+    EXPECT_TRUE(Alloc() == splicer::PoolAllocator<double>());
+    EXPECT_FALSE(Alloc() != splicer::PoolAllocator<double>());
+}
+
+TEST(PoolAllocator, List)
+{
+    std::list<int, splicer::PoolAllocator<int>> list;
+
+    for (int i(0); i < 1000; ++i) list.push_back(i);
+    list.remove_if([](int v) { return v % 2; });
+
+    ASSERT_EQ(list.size(), 500);
+
+    int i(0);
+    for (const int v : list)
+    {
+        ASSERT_EQ(v, i);
+        i += 2;
+    }
+}
+
+TEST(PoolAllocator, Containers)
+{
+    using Pair = std::pair<const int, std::string>;
+
+    std::map<int, std::string, std::less<int>, splicer::PoolAllocator<Pair>>
+        map;
+    std::set<int, std::less<int>, splicer::PoolAllocator<int>> set;
+    std::unordered_map<
+        int,
+        std::string,
+        std::hash<int>,
+        std::equal_to<int>,
+        splicer::PoolAllocator<Pair>> hashed;
+
+    for (int i(0); i < 1000; ++i)
+    {
+        map[i] = std::to_string(i);
+        set.insert(i);
+        hashed[i] = std::to_string(i);
+    }
+
+    for (int i(0); i < 1000; i += 2)
+    {
+        map.erase(i);
+        set.erase(i);
+        hashed.erase(i);
+    }
+
+    ASSERT_EQ(map.size(), 500);
+    ASSERT_EQ(set.size(), 500);
+    ASSERT_EQ(hashed.size(), 500);
+
+    for (int i(1); i < 1000; i += 2)
+    {
+        ASSERT_EQ(map.at(i), std::to_string(i));
+        ASSERT_TRUE(set.count(i));
+        ASSERT_EQ(hashed.at(i), std::to_string(i));
+    }
+}
+
+TEST(PoolAllocator, CrossThread)
+{
+    using List = std::list<std::size_t, splicer::PoolAllocator<std::size_t>>;
+
+    const std::size_t count(10000);
+    std::vector<List> lists(4);
+    std::vector<std::thread> threads;
+
+    for (std::size_t t(0); t < lists.size(); ++t)
+    {
+        threads.emplace_back([&lists, t, count]()
+        {
+            for (std::size_t i(0); i < count; ++i) lists[t].push_back(i);
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    for (const auto& list : lists) ASSERT_EQ(list.size(), count);
+
+    // Deallocate everything from this thread instead.
+    lists.clear();
+}
@@ -0,0 +1,192 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+
+#include "splice-async.hpp"
+#include "gtest/gtest.h"
+#include "temp-path.hpp"
+
+namespace
+{
+    const std::size_t bufferSize(4096);
+    const std::size_t count(300);
+
+    // Write count buffers, each filled with its index, then read them back
+    // in a different order and verify them.
+    void roundTrip(
+            splicer::BufferPool<char>& pool,
+            splicer::IoEngine<char>& engine)
+    {
+        using Completions = std::vector<splicer::IoEngine<char>::Completion>;
+
+        const std::string path(tempPath("async"));
+        const int fd(open(path.c_str(), O_RDWR));
+        ASSERT_GE(fd, 0);
+
+        for (std::size_t i(0); i < count; ++i)
+        {
+            splicer::UniqueNode<char*> node(pool.acquireOne());
+            std::memset(*node, i % 128, bufferSize);
+            engine.write(fd, std::move(node), bufferSize, i * bufferSize, i);
+        }
+
+        std::size_t done(0);
+
+        while (engine.outstanding())
+        {
+            Completions completions(engine.wait(16));
+
+            for (const auto& c : completions)
+            {
+                ASSERT_EQ(c.result, static_cast<int>(bufferSize));
+                ASSERT_TRUE(c.buffer.get());
+                ++done;
+            }
+        }
+
+        ASSERT_EQ(done, count);
+        EXPECT_EQ(pool.available(), pool.allocated());
+
+        for (std::size_t i(count - 1); i < count; --i)
+        {
+            engine.read(fd, pool.acquireOne(), bufferSize, i * bufferSize, i);
+        }
+
+        // A read beyond the end of the file completes with zero bytes.
+        engine.read(fd, pool.acquireOne(), bufferSize, count * bufferSize, 0);
+        // Engines with bounded queues may have submitted some already.
+        EXPECT_LE(engine.submit(), count + 1);
+        EXPECT_EQ(engine.outstanding(), count + 1);
+
+        Completions completions(engine.wait(count + 1));
+        ASSERT_EQ(completions.size(), count + 1);
+
+        for (const auto& c : completions)
+        {
+            if (c.result == 0) continue;
+
+            ASSERT_EQ(c.result, static_cast<int>(bufferSize));
+
+            const char* data(*c.buffer);
+            for (std::size_t j(0); j < bufferSize; ++j)
+            {
+                ASSERT_EQ(data[j], static_cast<char>(c.tag % 128));
+            }
+        }
+
+        completions.clear();
+        EXPECT_EQ(pool.available(), pool.allocated());
+
+        close(fd);
+        std::remove(path.c_str());
+    }
+}
+
+TEST(Async, ThreadEngine)
+{
+    splicer::BufferPool<char> pool(bufferSize, 64, splicer::Zeroing::Never);
+    splicer::ThreadIoEngine<char> engine(pool, 4);
+
+    roundTrip(pool, engine);
+}
+
+#if defined(SPLICE_POOL_IO_URING)
+TEST(Async, UringEngine)
+{
+    splicer::BufferPool<char> pool(bufferSize, 64, splicer::Zeroing::Never);
+
+    // Allocate some blocks up front so that they are registered, while
+    // later blocks are not.
+    pool.acquire(count / 2).reset();
+
+    std::unique_ptr<splicer::UringIoEngine<char>> engine;
+
+    try
+    {
+        engine.reset(new splicer::UringIoEngine<char>(pool, 64));
+    }
+    catch (const std::system_error&)
+    {
+        std::cout << "io_uring unavailable, skipping" << std::endl;
+        return;
+    }
+
+    roundTrip(pool, *engine);
+}
+
+TEST(Async, UringFixed)
+{
+    using Completions = std::vector<splicer::IoEngine<char>::Completion>;
+
+    splicer::BufferPool<char> pool(bufferSize, 64, splicer::Zeroing::Never);
+    pool.acquire(64).reset();
+
+    std::unique_ptr<splicer::UringIoEngine<char>> engine;
+
+    try
+    {
+        engine.reset(new splicer::UringIoEngine<char>(pool, 64));
+    }
+    catch (const std::system_error&)
+    {
+        std::cout << "io_uring unavailable, skipping" << std::endl;
+        return;
+    }
+
+    const std::string path(tempPath("async"));
+    const int fd(open(path.c_str(), O_RDWR));
+    ASSERT_GE(fd, 0);
+
+    // Every buffer of the first block is registered, and a block allocated
+    // after construction is not until it is refreshed.
+    splicer::UniqueStack<char*> held(pool.acquire(64));
+    for (char* buffer : held) EXPECT_TRUE(engine->fixed(buffer));
+
+    splicer::UniqueNode<char*> late(pool.acquireOne());
+    EXPECT_FALSE(engine->fixed(*late));
+
+    // A fixed request whose buffer lies outside its registered block fails
+    // with -EFAULT, so these succeed only with the right buffer index.
+    splicer::UniqueNode<char*> node(held.popOne());
+    std::memset(*node, 'x', bufferSize);
+    engine->write(fd, std::move(node), bufferSize, 0);
+
+    Completions written(engine->wait(1));
+    ASSERT_EQ(written.size(), 1u);
+    EXPECT_EQ(written[0].result, static_cast<int>(bufferSize));
+
+    engine->read(fd, std::move(written[0].buffer), bufferSize, 0);
+    EXPECT_FALSE(engine->refresh());
+
+    Completions read(engine->wait(1));
+    ASSERT_EQ(read.size(), 1u);
+    ASSERT_EQ(read[0].result, static_cast<int>(bufferSize));
+    EXPECT_EQ((*read[0].buffer)[bufferSize - 1], 'x');
+    read.clear();
+
+    EXPECT_TRUE(engine->refresh());
+    EXPECT_TRUE(engine->fixed(*late));
+    EXPECT_TRUE(engine->fixed(held.head()->val()));
+
+    engine->read(fd, std::move(late), bufferSize, 0);
+    Completions refreshed(engine->wait(1));
+    ASSERT_EQ(refreshed.size(), 1u);
+    ASSERT_EQ(refreshed[0].result, static_cast<int>(bufferSize));
+    EXPECT_EQ((*refreshed[0].buffer)[0], 'x');
+
+    close(fd);
+    std::remove(path.c_str());
+}
+#endif
+
+TEST(Async, MakeEngine)
+{
+    splicer::BufferPool<char> pool(bufferSize, 64, splicer::Zeroing::Never);
+    std::unique_ptr<splicer::IoEngine<char>> engine(
+            splicer::makeIoEngine(pool));
+
+    ASSERT_TRUE(engine.get());
+    roundTrip(pool, *engine);
+}
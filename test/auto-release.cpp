@@ -415,3 +415,76 @@ TEST(UniqueSemantics, PushBack)
     for (const auto n : stack) ASSERT_EQ(n, i++);
 }
 
+TEST(UniqueSemantics, Merge)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+    splicer::ObjectPool<int>::UniqueStackType stack(pool);
+    splicer::ObjectPool<int>::UniqueStackType other(pool);
+
+    for (int i(0); i < 40; ++i)
+    {
+        if (i % 3) stack.pushBack(pool.acquireOne(i));
+        else other.pushBack(pool.acquireOne(i));
+    }
+
+    stack.merge(std::move(other), std::less<int>());
+
+    EXPECT_EQ(stack.size(), 40);
+    EXPECT_TRUE(other.empty());
+
+    int i(0);
+    for (const auto n : stack) ASSERT_EQ(n, i++);
+}
+
+TEST(UniqueSemantics, PushSorted)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+    splicer::ObjectPool<int>::UniqueStackType stack(pool);
+    splicer::ObjectPool<int>::UniqueStackType other(pool);
+
+    for (int i(0); i < 40; ++i)
+    {
+        if (i % 4) stack.pushBack(pool.acquireOne(i));
+        else other.pushBack(pool.acquireOne(i));
+    }
+
+    stack.pushSorted(std::move(other), std::less<int>());
+
+    EXPECT_EQ(stack.size(), 40);
+    EXPECT_TRUE(other.empty());
+
+    int i(0);
+    for (const auto n : stack) ASSERT_EQ(n, i++);
+}
+
+TEST(UniqueSemantics, JumpIndex)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+    splicer::ObjectPool<int>::UniqueStackType stack(pool);
+
+    for (int i(0); i < 100; ++i) stack.pushBack(pool.acquireOne(i));
+
+    int i(0);
+    for (const int v : stack.jumpIndex(16)) ASSERT_EQ(v, i++);
+
+    int sum(0);
+    stack.forEachBatch([&sum](int v) { sum += v; }, 8);
+    EXPECT_EQ(sum, 4950);
+}
+
+TEST(UniqueSemantics, Sort)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+    splicer::ObjectPool<int>::UniqueStackType stack(pool);
+
+    for (int i(0); i < 100; ++i) stack.push(pool.acquireOne(i));
+
+    stack.sort(std::less<int>());
+
+    int i(0);
+    for (const auto n : stack) ASSERT_EQ(n, i++);
+
+    stack.sortByKey([](int v) { return -v; });
+
+    for (const auto n : stack) ASSERT_EQ(n, --i);
+}
@@ -0,0 +1,231 @@
+#include <cstring>
+
+#include "splice-pool.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    const std::size_t blockSize(20);
+    const std::size_t bufferSize(64);
+}
+
+TEST(BufferPool, AcquireRelease)
+{
+    splicer::BufferPool<char> pool(bufferSize, blockSize);
+
+    {
+        splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(30));
+        ASSERT_EQ(stack.size(), 30);
+
+        for (char* buffer : stack) std::memset(buffer, 1, bufferSize);
+
+        EXPECT_EQ(pool.available(), pool.allocated() - 30);
+    }
+
+    EXPECT_EQ(pool.available(), pool.allocated());
+
+    // Released buffers are zeroed.
+    splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(30));
+
+    for (const char* buffer : stack)
+    {
+        for (std::size_t i(0); i < bufferSize; ++i) ASSERT_EQ(buffer[i], 0);
+    }
+}
+
+TEST(BufferPool, Find)
+{
+    splicer::BufferPool<char> pool(bufferSize, blockSize);
+    splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(50));
+
+    for (splicer::Node<char*>* node(stack.head()); node; node = node->next())
+    {
+        ASSERT_EQ(pool.find(node->val()), node);
+    }
+
+    char local(0);
+    EXPECT_FALSE(pool.find(&local));
+    EXPECT_FALSE(pool.find(stack.head()->val() + 1));
+}
+
+TEST(BufferPool, ZeroingNever)
+{
+    splicer::BufferPool<char> pool(
+            bufferSize,
+            blockSize,
+            splicer::Zeroing::Never);
+
+    char* buffer(nullptr);
+
+    {
+        splicer::BufferPool<char>::UniqueNodeType node(pool.acquireOne());
+        buffer = *node;
+        std::memset(buffer, 1, bufferSize);
+    }
+
+    // Released without zeroing.
+    EXPECT_EQ(buffer[0], 1);
+    EXPECT_EQ(buffer[bufferSize - 1], 1);
+
+    splicer::BufferPool<char>::UniqueNodeType node(pool.acquireOneZeroed());
+    ASSERT_EQ(*node, buffer);
+
+    for (std::size_t i(0); i < bufferSize; ++i) ASSERT_EQ(buffer[i], 0);
+}
+
+TEST(BufferPool, ZeroingDirty)
+{
+    splicer::BufferPool<char> pool(
+            bufferSize,
+            blockSize,
+            splicer::Zeroing::Dirty);
+
+    char* buffer(nullptr);
+
+    {
+        splicer::BufferPool<char>::UniqueNodeType node(pool.acquireOne());
+        buffer = *node;
+        std::memset(buffer, 1, bufferSize);
+
+        // Only claim the first half, so the rest remains as-is.
+        pool.dirty(buffer, bufferSize / 2);
+    }
+
+    EXPECT_EQ(buffer[0], 0);
+    EXPECT_EQ(buffer[bufferSize / 2 - 1], 0);
+    EXPECT_EQ(buffer[bufferSize / 2], 1);
+
+    {
+        splicer::BufferPool<char>::UniqueNodeType node(pool.acquireOne());
+        ASSERT_EQ(*node, buffer);
+        std::memset(buffer, 1, bufferSize);
+    }
+
+    // Without a mark, the whole buffer is zeroed.
+    for (std::size_t i(0); i < bufferSize; ++i) ASSERT_EQ(buffer[i], 0);
+
+    {
+        splicer::BufferPool<char>::UniqueNodeType node(pool.acquireOne());
+        ASSERT_EQ(*node, buffer);
+        std::memset(buffer, 1, bufferSize);
+
+        // A shorter mark does not shrink a longer one.
+        pool.dirty(buffer, bufferSize);
+        pool.dirty(buffer, 16);
+    }
+
+    for (std::size_t i(0); i < bufferSize; ++i) ASSERT_EQ(buffer[i], 0);
+}
+
+TEST(BufferPool, ZeroFill)
+{
+    // Cover the memset, streaming, and page discarding cases, with ranges
+    // which start and end off of any alignment boundary.
+    const std::vector<std::size_t> sizes{
+        100,
+        splicer::zero::streamThreshold + 100,
+        splicer::zero::discardThreshold * 2 + 100 };
+
+    for (const std::size_t size : sizes)
+    {
+        std::vector<char> data(size + 16, 1);
+        splicer::zero::fill(data.data() + 3, size);
+
+        ASSERT_EQ(data[2], 1);
+        for (std::size_t i(3); i < size + 3; ++i) ASSERT_EQ(data[i], 0);
+        ASSERT_EQ(data[size + 3], 1);
+    }
+}
+
+TEST(BufferPool, ZeroLargeStack)
+{
+    const std::size_t largeSize(65536);
+    const std::size_t count(16);
+
+    splicer::BufferPool<char> pool(largeSize, count);
+
+    {
+        splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(count));
+        for (char* buffer : stack) std::memset(buffer, 1, largeSize);
+    }
+
+    splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(count));
+
+    for (const char* buffer : stack)
+    {
+        for (std::size_t i(0); i < largeSize; ++i) ASSERT_EQ(buffer[i], 0);
+    }
+}
+
+TEST(SizeClassBufferPool, Classes)
+{
+    splicer::SizeClassBufferPool<char> pool(16, 1000, 4);
+
+    // 16, 64, 256, 1000.
+    ASSERT_EQ(pool.classes(), 4);
+    EXPECT_EQ(pool.maxSize(), 1000);
+
+    EXPECT_EQ(pool.classFor(1), 0);
+    EXPECT_EQ(pool.classFor(16), 0);
+    EXPECT_EQ(pool.classFor(17), 1);
+    EXPECT_EQ(pool.classFor(256), 2);
+    EXPECT_EQ(pool.classFor(257), 3);
+    EXPECT_EQ(pool.classFor(1000), 3);
+    EXPECT_EQ(pool.classFor(1001), 4);
+
+    EXPECT_THROW(pool.acquireOne(1001), std::length_error);
+}
+
+TEST(SizeClassBufferPool, ReleaseWithoutClass)
+{
+    splicer::SizeClassBufferPool<char> pool(16, 4096);
+
+    splicer::Stack<char*> mixed;
+    std::vector<char*> buffers;
+
+    for (std::size_t length(1); length <= 4096; length *= 3)
+    {
+        splicer::Node<char*>* node(pool.acquireOne(length).release());
+        ASSERT_EQ(pool.find(node->val()), &pool.pool(pool.classFor(length)));
+        mixed.push(node);
+    }
+
+    pool.release(std::move(mixed));
+    EXPECT_TRUE(mixed.empty());
+
+    for (std::size_t i(0); i < pool.classes(); ++i)
+    {
+        EXPECT_EQ(pool.pool(i).available(), pool.pool(i).allocated());
+    }
+
+    char* buffer(pool.acquireOne(100).release()->val());
+    pool.release(buffer);
+
+    EXPECT_EQ(pool.pool(pool.classFor(100)).available(),
+            pool.pool(pool.classFor(100)).allocated());
+}
+
+TEST(SizeClassBufferPool, ReleaseUnowned)
+{
+    splicer::SizeClassBufferPool<char> pool(16, 4096);
+
+    char foreign[16];
+    splicer::Node<char*> node;
+    *node = foreign;
+
+    EXPECT_THROW(pool.release(foreign), std::invalid_argument);
+    EXPECT_THROW(pool.release(foreign, 16), std::invalid_argument);
+
+    // Owned buffers are still released, and the unowned one is handed back.
+    splicer::Stack<char*> mixed;
+    splicer::Node<char*>* owned(pool.acquireOne(100).release());
+    mixed.push(owned);
+    mixed.push(&node);
+
+    EXPECT_THROW(pool.release(std::move(mixed)), std::invalid_argument);
+    ASSERT_EQ(mixed.size(), 1);
+    EXPECT_EQ(mixed.head(), &node);
+
+    const auto& released(pool.pool(pool.classFor(100)));
+    EXPECT_EQ(released.available(), released.allocated());
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "splice-channel.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    using Pool = splicer::ObjectPool<int>;
+    using Channel = splicer::StackChannel<int>;
+
+    Pool::UniqueStackType make(Pool& pool, int begin, int end)
+    {
+        Pool::UniqueStackType stack(pool);
+        for (int i(begin); i < end; ++i) stack.pushBack(pool.acquireOne(i));
+        return stack;
+    }
+}
+
+TEST(StackChannel, Order)
+{
+    Pool pool(64);
+    Channel channel(pool);
+
+    EXPECT_TRUE(channel.tryReceive().empty());
+
+    EXPECT_TRUE(channel.send(make(pool, 0, 10)));
+    EXPECT_TRUE(channel.send(pool.acquireOne(10)));
+    EXPECT_TRUE(channel.send(make(pool, 11, 20)));
+    EXPECT_EQ(channel.size(), 20);
+
+    Pool::UniqueStackType some(channel.receive(5));
+    ASSERT_EQ(some.size(), 5);
+
+    Pool::UniqueStackType rest(channel.receive());
+    ASSERT_EQ(rest.size(), 15);
+    EXPECT_EQ(channel.size(), 0);
+
+    int i(0);
+    for (const int v : some) EXPECT_EQ(v, i++);
+    for (const int v : rest) EXPECT_EQ(v, i++);
+}
+
+TEST(StackChannel, Close)
+{
+    Pool pool(64);
+    Channel channel(pool);
+
+    channel.send(make(pool, 0, 10));
+    channel.close();
+
+    EXPECT_TRUE(channel.closed());
+
+    Pool::UniqueStackType rejected(make(pool, 10, 20));
+    EXPECT_FALSE(channel.send(std::move(rejected)));
+    EXPECT_EQ(rejected.size(), 10);
+
+    Pool::UniqueNodeType single(pool.acquireOne(20));
+    EXPECT_FALSE(channel.send(std::move(single)));
+    ASSERT_FALSE(single.empty());
+    EXPECT_EQ(single.get()->val(), 20);
+
+    // Remaining nodes drain, then receives return immediately.
+    EXPECT_EQ(channel.receive().size(), 10);
+    EXPECT_TRUE(channel.receive().empty());
+}
+
+TEST(StackChannel, Timeout)
+{
+    Pool pool(64);
+    Channel channel(pool);
+
+    const auto start(std::chrono::steady_clock::now());
+    EXPECT_TRUE(channel.receiveFor(std::chrono::milliseconds(20)).empty());
+    EXPECT_GE(
+            std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+
+    std::thread sender([&]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        channel.send(make(pool, 0, 3));
+    });
+
+    Pool::UniqueStackType received(
+            channel.receiveUntil(
+                std::chrono::steady_clock::now() + std::chrono::seconds(10)));
+    EXPECT_EQ(received.size(), 3);
+
+    sender.join();
+}
+
+TEST(StackChannel, Concurrent)
+{
+    Pool pool(4096);
+    Channel channel(pool);
+
+    const int producers(4);
+    const int batches(1000);
+    const int batchSize(32);
+
+    std::vector<std::thread> threads;
+    std::vector<long> sums(4, 0);
+    std::vector<std::size_t> counts(4, 0);
+
+    for (int c(0); c < 4; ++c)
+    {
+        threads.emplace_back([&, c]()
+        {
+            while (true)
+            {
+                Pool::UniqueStackType stack(channel.receive(100));
+                if (stack.empty()) break;
+
+                for (const int v : stack) sums[c] += v;
+                counts[c] += stack.size();
+            }
+        });
+    }
+
+    std::vector<std::thread> senders;
+    for (int p(0); p < producers; ++p)
+    {
+        senders.emplace_back([&]()
+        {
+            for (int b(0); b < batches; ++b)
+            {
+                ASSERT_TRUE(channel.send(make(pool, 0, batchSize)));
+            }
+        });
+    }
+
+    for (auto& t : senders) t.join();
+    channel.close();
+    for (auto& t : threads) t.join();
+
+    long sum(0);
+    std::size_t count(0);
+    for (int c(0); c < 4; ++c)
+    {
+        sum += sums[c];
+        count += counts[c];
+    }
+
+    EXPECT_EQ(count, producers * batches * batchSize);
+    EXPECT_EQ(sum, producers * batches * (batchSize * (batchSize - 1) / 2));
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
@@ -0,0 +1,137 @@
+#include <map>
+#include <random>
+#include <string>
+
+#include "splice-hash-map.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    using Map = splicer::HashMap<int, std::string>;
+}
+
+TEST(HashMap, Basic)
+{
+    Map::Pool pool(256);
+    Map map(pool);
+
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.find(1));
+    EXPECT_FALSE(map.erase(1));
+
+    EXPECT_TRUE(map.insert(1, "one").second);
+    EXPECT_FALSE(map.insert(1, "uno").second);
+    map[2] = "two";
+
+    ASSERT_TRUE(map.find(1));
+    EXPECT_EQ(*map.find(1), "one");
+    EXPECT_EQ(map[2], "two");
+    EXPECT_EQ(map.size(), 2);
+
+    EXPECT_TRUE(map.erase(1));
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_TRUE(map.contains(2));
+    EXPECT_EQ(map.size(), 1);
+}
+
+TEST(HashMap, Random)
+{
+    Map::Pool pool(256);
+    Map map(pool, 4);
+    std::map<int, std::string> reference;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 5000);
+
+    for (int i(0); i < 50000; ++i)
+    {
+        const int key(dist(gen));
+
+        if (i % 3)
+        {
+            const std::string value(std::to_string(i));
+            const bool inserted(map.insert(key, value).second);
+            EXPECT_EQ(inserted, reference.insert({ key, value }).second);
+        }
+        else
+        {
+            EXPECT_EQ(map.erase(key), reference.erase(key) == 1);
+        }
+    }
+
+    ASSERT_EQ(map.size(), reference.size());
+    EXPECT_GE(map.bucketCount(), map.size());
+
+    for (const auto& p : reference)
+    {
+        const std::string* value(map.find(p.first));
+        ASSERT_TRUE(value);
+        EXPECT_EQ(*value, p.second);
+    }
+
+    std::size_t count(0);
+    map.forEach([&](const Map::Entry& entry)
+    {
+        EXPECT_EQ(reference.at(entry.first), entry.second);
+        ++count;
+    });
+    EXPECT_EQ(count, reference.size());
+}
+
+TEST(HashMap, ReserveAndClear)
+{
+    Map::Pool pool(256);
+
+    {
+        Map map(pool);
+        map.reserve(1000);
+
+        EXPECT_GE(map.bucketCount(), 1000);
+        EXPECT_GE(pool.allocated(), 1000);
+
+        const std::size_t allocated(pool.allocated());
+        const std::size_t buckets(map.bucketCount());
+
+        for (int i(0); i < 1000; ++i) map[i] = std::to_string(i);
+
+        // Nothing further was acquired, and no rehash occurred.
+        EXPECT_EQ(pool.allocated(), allocated);
+        EXPECT_EQ(map.bucketCount(), buckets);
+
+        map.clear();
+        EXPECT_TRUE(map.empty());
+        EXPECT_FALSE(map.contains(10));
+        EXPECT_EQ(pool.available(), allocated);
+
+        // Usable after clearing, with recycled nodes.
+        map[5] = "five";
+        EXPECT_EQ(map[5], "five");
+        EXPECT_EQ(pool.allocated(), allocated);
+    }
+
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
+
+TEST(HashMap, Replace)
+{
+    Map::Pool pool(256);
+    Map map(pool);
+
+    map.insert(1, "one");
+    map.insert(2, "two");
+    const std::size_t available(pool.available());
+
+    Map::Entry* entry(map.replace(1, 3, "three"));
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->first, 3);
+    EXPECT_EQ(entry->second, "three");
+
+    EXPECT_FALSE(map.contains(1));
+    ASSERT_TRUE(map.find(3));
+    EXPECT_EQ(*map.find(3), "three");
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(pool.available(), available);
+
+    EXPECT_FALSE(map.replace(1, 4, "four"));
+    EXPECT_FALSE(map.contains(4));
+}
@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "splice-io.hpp"
+#include "gtest/gtest.h"
+#include "temp-path.hpp"
+
+namespace
+{
+    const std::size_t bufferSize(4096);
+    const std::size_t alignment(4096);
+}
+
+TEST(IO, AlignedBuffers)
+{
+    for (const std::size_t align : { 16, 64, 512, 4096 })
+    {
+        // Buffer size not a multiple of the alignment, so buffers are padded.
+        splicer::BufferPool<char> pool(
+                100,
+                8,
+                splicer::Zeroing::Release,
+                align);
+
+        splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(20));
+
+        for (char* buffer : stack)
+        {
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % align, 0);
+            ASSERT_TRUE(pool.find(buffer));
+            std::memset(buffer, 1, 100);
+        }
+
+        stack.reset();
+        stack = pool.acquire(20);
+
+        for (const char* buffer : stack)
+        {
+            for (std::size_t i(0); i < 100; ++i) ASSERT_EQ(buffer[i], 0);
+        }
+    }
+}
+
+TEST(IO, DirectReadWrite)
+{
+    const std::string path(tempPath("io"));
+    const std::size_t count(4);
+
+    splicer::BufferPool<char> pool(
+            bufferSize,
+            count,
+            splicer::Zeroing::Never,
+            alignment);
+
+    {
+        splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(count));
+
+        char c(0);
+        for (char* buffer : stack) std::memset(buffer, ++c, bufferSize);
+
+        splicer::DirectFile file(path, O_WRONLY | O_CREAT | O_TRUNC);
+        file.writeStack(stack, bufferSize, 0);
+    }
+
+    {
+        splicer::BufferPool<char>::UniqueStackType stack(
+                pool.acquireZeroed(count + 1));
+
+        splicer::DirectFile file(path);
+
+        // Short read, since there is one more buffer than the file holds.
+        EXPECT_EQ(file.readStack(stack, bufferSize, 0), count * bufferSize);
+
+        char c(0);
+        std::size_t i(0);
+
+        for (const char* buffer : stack)
+        {
+            if (i++ < count) ++c;
+            else c = 0;
+
+            for (std::size_t j(0); j < bufferSize; ++j)
+            {
+                ASSERT_EQ(buffer[j], c);
+            }
+        }
+    }
+
+    {
+        // Raw pointers select the single buffer overloads.
+        splicer::BufferPool<char>::UniqueNodeType node(pool.acquireOne());
+        char* raw(node.get()->val());
+
+        splicer::DirectFile file(path, O_RDWR);
+        EXPECT_EQ(file.read(raw, bufferSize, bufferSize), bufferSize);
+        EXPECT_EQ(raw[0], 2);
+
+        file.write(raw, bufferSize, 0);
+        EXPECT_EQ(file.read(raw, bufferSize, 0), bufferSize);
+        EXPECT_EQ(raw[bufferSize - 1], 2);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(IO, DirectOpenFailure)
+{
+    EXPECT_THROW(
+            splicer::DirectFile("/nonexistent/splice-pool"),
+            std::system_error);
+}
+
+TEST(IO, ScatterGather)
+{
+    const std::string path(tempPath("io"));
+    const std::size_t size(100);
+
+    // More buffers than fit in a single iovec batch.
+    const std::size_t count(splicer::iovMax() + 10);
+
+    splicer::BufferPool<char> pool(size, 64, splicer::Zeroing::Never);
+
+    {
+        splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(count));
+
+        std::size_t i(0);
+        for (char* buffer : stack) std::memset(buffer, i++ % 100, size);
+
+        const int fd(open(path.c_str(), O_WRONLY | O_TRUNC));
+        ASSERT_GE(fd, 0);
+        EXPECT_EQ(splicer::writeStack(fd, stack, size), count * size);
+
+        // Positional write over the first two buffers, shifted by half.
+        splicer::BufferPool<char>::UniqueStackType two(pool.acquire(2));
+        for (char* buffer : two) std::memset(buffer, 127, size);
+
+        EXPECT_EQ(splicer::pwriteStack(fd, two, size, size / 2), size * 2);
+        close(fd);
+    }
+
+    const int fd(open(path.c_str(), O_RDONLY));
+    ASSERT_GE(fd, 0);
+
+    {
+        // Reading into more buffers than needed releases the remainder.
+        splicer::BufferPool<char>::UniqueStackType stack(
+                pool.acquire(count + 50));
+
+        const std::size_t available(pool.available());
+
+        EXPECT_EQ(splicer::readStack(fd, stack, size), count * size);
+        EXPECT_EQ(stack.size(), count);
+        EXPECT_EQ(pool.available(), available + 50);
+
+        std::size_t i(0);
+        for (const char* buffer : stack)
+        {
+            for (std::size_t j(0); j < size; ++j)
+            {
+                const std::size_t pos(i * size + j);
+                const char expected(
+                        pos >= size / 2 && pos < size * 5 / 2 ?
+                            127 : i % 100);
+
+                ASSERT_EQ(buffer[j], expected);
+            }
+
+            ++i;
+        }
+    }
+
+    {
+        // Positional read ending with a partially filled buffer.
+        splicer::BufferPool<char>::UniqueStackType stack(pool.acquire(10));
+
+        const std::size_t offset((count - 2) * size + size / 2);
+
+        EXPECT_EQ(
+                splicer::preadStack(fd, stack, size, offset),
+                size * 3 / 2);
+        EXPECT_EQ(stack.size(), 2);
+        EXPECT_EQ((*stack.begin())[0], static_cast<char>((count - 2) % 100));
+    }
+
+    close(fd);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,132 @@
+#include <vector>
+
+#include "splice-list.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    using Pool = splicer::ObjectPool<splicer::DItem<int>>;
+    using List = splicer::UniqueDList<int>;
+
+    std::vector<int> forward(List& list)
+    {
+        std::vector<int> result;
+        for (const int v : list) result.push_back(v);
+        return result;
+    }
+
+    std::vector<int> backward(List& list)
+    {
+        std::vector<int> result;
+        for (auto it(list.rbegin()); it != list.rend(); ++it)
+        {
+            result.push_back(*it);
+        }
+        return result;
+    }
+}
+
+TEST(DList, BothEnds)
+{
+    Pool pool(64);
+    List list(pool);
+
+    list.pushBack(pool.acquireOne(2));
+    list.push(pool.acquireOne(1));
+    list.pushBack(pool.acquireOne(3));
+    list.push(pool.acquireOne(0));
+
+    EXPECT_EQ(forward(list), std::vector<int>({ 0, 1, 2, 3 }));
+    EXPECT_EQ(backward(list), std::vector<int>({ 3, 2, 1, 0 }));
+
+    EXPECT_EQ(**list.popBack(), 3);
+    EXPECT_EQ(**list.pop(), 0);
+    EXPECT_EQ(list.size(), 2);
+    EXPECT_EQ(forward(list), std::vector<int>({ 1, 2 }));
+    EXPECT_EQ(backward(list), std::vector<int>({ 2, 1 }));
+
+    list.pop();
+    list.pop();
+    EXPECT_TRUE(list.empty());
+    EXPECT_TRUE(list.pop().empty());
+    EXPECT_TRUE(list.popBack().empty());
+}
+
+TEST(DList, Unlink)
+{
+    Pool pool(64);
+    List list(pool.acquire(5));
+
+    int i(0);
+    for (int& v : list) v = i++;
+
+    splicer::DNode<int>* middle(list.head()->next()->next());
+    EXPECT_EQ(**list.unlink(middle), 2);
+    EXPECT_EQ(forward(list), std::vector<int>({ 0, 1, 3, 4 }));
+    EXPECT_EQ(backward(list), std::vector<int>({ 4, 3, 1, 0 }));
+
+    list.unlink(list.tail());
+    list.unlink(list.head());
+    EXPECT_EQ(forward(list), std::vector<int>({ 1, 3 }));
+    EXPECT_EQ(backward(list), std::vector<int>({ 3, 1 }));
+
+    list.moveToFront(list.tail());
+    EXPECT_EQ(forward(list), std::vector<int>({ 3, 1 }));
+
+    list.insertAfter(list.head(), pool.acquireOne(2));
+    list.insertBefore(nullptr, pool.acquireOne(0));
+    EXPECT_EQ(forward(list), std::vector<int>({ 3, 2, 1, 0 }));
+    EXPECT_EQ(backward(list), std::vector<int>({ 0, 1, 2, 3 }));
+}
+
+TEST(DList, Splice)
+{
+    Pool pool(64);
+
+    {
+        List a(pool);
+        List b(pool);
+        List c(pool);
+
+        for (int i(0); i < 3; ++i) a.pushBack(pool.acquireOne(i));
+        for (int i(3); i < 6; ++i) b.pushBack(pool.acquireOne(i));
+        for (int i(-3); i < 0; ++i) c.pushBack(pool.acquireOne(i));
+
+        a.pushBack(std::move(b));
+        a.push(std::move(c));
+        EXPECT_TRUE(b.empty());
+        EXPECT_TRUE(c.empty());
+
+        EXPECT_EQ(
+                forward(a),
+                std::vector<int>({ -3, -2, -1, 0, 1, 2, 3, 4, 5 }));
+        EXPECT_EQ(
+                backward(a),
+                std::vector<int>({ 5, 4, 3, 2, 1, 0, -1, -2, -3 }));
+
+        // Released to the pool as a single Stack.
+        const std::size_t available(pool.available());
+        a.reset();
+        EXPECT_EQ(pool.available(), available + 9);
+    }
+
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
+
+TEST(DItem, Copy)
+{
+    // Copies of a non-const lvalue are copies, not a forwarded value.
+    splicer::DItem<std::vector<int>> item(3, 7);
+    splicer::DItem<std::vector<int>> copy(item);
+    EXPECT_EQ(copy.val, item.val);
+
+    const splicer::DItem<std::vector<int>>& ref(item);
+    splicer::DItem<std::vector<int>> constCopy(ref);
+    EXPECT_EQ(constCopy.val, std::vector<int>(3, 7));
+
+    splicer::DItem<std::vector<int>> moved(std::move(copy));
+    EXPECT_EQ(moved.val.size(), 3u);
+
+    splicer::DItem<std::vector<int>> empty;
+    EXPECT_TRUE(empty.val.empty());
+}
@@ -0,0 +1,178 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "splice-lru.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    using Cache = splicer::LruCache<int, std::string>;
+
+    struct Counted
+    {
+        Counted() { ++constructed; }
+        Counted(const Counted&) { ++constructed; }
+        Counted& operator=(const Counted&) = default;
+        ~Counted() { ++destroyed; }
+
+        static std::size_t constructed;
+        static std::size_t destroyed;
+    };
+
+    std::size_t Counted::constructed(0);
+    std::size_t Counted::destroyed(0);
+}
+
+TEST(LruCache, Eviction)
+{
+    // A single shard, so eviction order is global.
+    Cache cache(3, 1);
+    std::string value;
+
+    cache.put(1, "one");
+    cache.put(2, "two");
+    cache.put(3, "three");
+
+    // Touch 1, so 2 is now the least recently used.
+    ASSERT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "one");
+
+    cache.put(4, "four");
+    EXPECT_EQ(cache.size(), 3);
+    EXPECT_FALSE(cache.contains(2));
+    EXPECT_TRUE(cache.contains(1));
+
+    // Overwriting also counts as a use.
+    cache.put(3, "drei");
+    cache.put(5, "five");
+    EXPECT_FALSE(cache.contains(1));
+
+    ASSERT_TRUE(cache.get(3, value));
+    EXPECT_EQ(value, "drei");
+
+    EXPECT_TRUE(cache.erase(3));
+    EXPECT_FALSE(cache.erase(3));
+    EXPECT_EQ(cache.size(), 2);
+
+    cache.put(6, "six");
+    cache.put(7, "seven");
+    EXPECT_FALSE(cache.contains(4));
+    EXPECT_TRUE(cache.contains(5));
+}
+
+TEST(LruCache, Bounded)
+{
+    Cache cache(1000, 8);
+    EXPECT_EQ(cache.capacity(), 1000);
+
+    // Nodes for the full capacity are acquired up front.
+    const std::size_t allocated(cache.pool().allocated());
+    EXPECT_GE(allocated, 1000);
+
+    for (int i(0); i < 100000; ++i) cache.put(i, std::to_string(i));
+
+    EXPECT_EQ(cache.size(), 1000);
+    EXPECT_EQ(cache.pool().allocated(), allocated);
+
+    // Evicted nodes were reused, and never returned to the pool.
+    EXPECT_EQ(cache.pool().available(), allocated - 1000);
+}
+
+TEST(LruCache, UnevenCapacity)
+{
+    // Shards hold either 62 or 63 entries, for exactly the capacity asked.
+    Cache cache(1000, 16);
+    EXPECT_EQ(cache.capacity(), 1000);
+
+    for (int i(0); i < 10000; ++i) cache.put(i, std::to_string(i));
+    EXPECT_EQ(cache.size(), 1000);
+
+    // Fewer entries than shards.
+    Cache tiny(3, 16);
+    EXPECT_EQ(tiny.capacity(), 3);
+
+    for (int i(0); i < 100; ++i) tiny.put(i, std::to_string(i));
+    EXPECT_EQ(tiny.size(), 3);
+    EXPECT_TRUE(tiny.contains(99));
+}
+
+TEST(LruCache, EvictInPlace)
+{
+    splicer::LruCache<int, Counted> cache(10, 1);
+    const Counted value;
+
+    for (int i(0); i < 10; ++i) cache.put(i, value);
+    const std::size_t available(cache.pool().available());
+
+    Counted::constructed = 0;
+    Counted::destroyed = 0;
+
+    // Each eviction destroys its victim and constructs the new entry once,
+    // in the same node, rather than resetting it on release to the pool and
+    // constructing it again on acquisition.
+    for (int i(10); i < 110; ++i) cache.put(i, value);
+
+    EXPECT_EQ(Counted::constructed, 100u);
+    EXPECT_EQ(Counted::destroyed, 100u);
+    EXPECT_EQ(cache.size(), 10u);
+    EXPECT_EQ(cache.pool().available(), available);
+    EXPECT_FALSE(cache.contains(99));
+    EXPECT_TRUE(cache.contains(109));
+}
+
+TEST(LruCache, Invalidate)
+{
+    Cache cache(100, 4);
+    for (int i(0); i < 100; ++i) cache.put(i, std::to_string(i));
+
+    const auto odd([](int key, const std::string&) { return key % 2; });
+    EXPECT_EQ(cache.eraseIf(odd), 50);
+    EXPECT_EQ(cache.size(), 50);
+    EXPECT_FALSE(cache.contains(1));
+    EXPECT_TRUE(cache.contains(2));
+
+    // Recency lists remain consistent after bulk erasure.
+    for (int i(100); i < 300; ++i) cache.put(i, std::to_string(i));
+    EXPECT_EQ(cache.size(), 100);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.pool().available(), cache.pool().allocated());
+
+    cache.put(1, "one");
+    EXPECT_TRUE(cache.contains(1));
+}
+
+TEST(LruCache, Concurrent)
+{
+    Cache cache(512, 8);
+    const std::size_t allocated(cache.pool().allocated());
+
+    std::vector<std::thread> threads;
+    for (int t(0); t < 4; ++t)
+    {
+        threads.emplace_back([&cache, t]()
+        {
+            std::string value;
+
+            for (int i(0); i < 50000; ++i)
+            {
+                const int key((i * 7 + t) % 2000);
+                if (cache.get(key, value))
+                {
+                    ASSERT_EQ(value, std::to_string(key));
+                }
+                else
+                {
+                    cache.put(key, std::to_string(key));
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    EXPECT_LE(cache.size(), 512);
+    EXPECT_EQ(cache.pool().allocated(), allocated);
+}
@@ -1,3 +1,7 @@
+#include <set>
+#include <thread>
+#include <vector>
+
 #include "splice-pool.hpp"
 #include "gtest/gtest.h"
 
@@ -185,3 +189,127 @@ TEST(ObjectPool, AcquireStackFromPopulated)
     EXPECT_EQ(pool.allocated(), size);
 }
 
+TEST(ObjectPool, AcquireChunks)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+
+    // Mix single and bulk traffic so that the free list holds chunks of many
+    // sizes, from several threads at once.
+    std::vector<std::thread> threads;
+    for (std::size_t t(0); t < 4; ++t)
+    {
+        threads.emplace_back([&pool, t]()
+        {
+            std::vector<splicer::ObjectPool<int>::UniqueStackType> held;
+
+            for (std::size_t i(0); i < 2000; ++i)
+            {
+                const std::size_t count((i * 7 + t) % (blockSize * 3));
+
+                if (i % 5 == 0) pool.release(pool.acquireOne(i));
+                else held.push_back(pool.acquire(count));
+
+                if (held.size() > 8) held.erase(held.begin());
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    ASSERT_EQ(pool.available(), pool.allocated());
+
+    // Every node is handed out exactly once.
+    const std::size_t size(pool.available());
+    splicer::Stack<int> stack(pool.acquire(size).release());
+    ASSERT_EQ(stack.size(), size);
+    EXPECT_EQ(pool.available(), 0);
+    EXPECT_EQ(pool.allocated(), size);
+
+    std::set<splicer::Node<int>*> seen;
+    for (auto node(stack.head()); node; node = node->next()) seen.insert(node);
+    EXPECT_EQ(seen.size(), size);
+
+    pool.release(std::move(stack));
+    EXPECT_EQ(pool.available(), size);
+}
+
+TEST(ObjectPool, AcquireAfterLargeRelease)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+    pool.release(pool.acquire(blockSize * 100));
+
+    const std::size_t allocated(pool.allocated());
+    ASSERT_EQ(pool.available(), allocated);
+
+    // Loose nodes which are out being cut are still counted as available,
+    // and concurrent acquirers wait for them rather than allocating.
+    std::vector<std::thread> threads;
+    std::vector<splicer::Stack<int>> held(4);
+
+    for (std::size_t t(0); t < held.size(); ++t)
+    {
+        threads.emplace_back([&pool, &held, t]()
+        {
+            for (std::size_t i(0); i < blockSize * 2; ++i)
+            {
+                splicer::Stack<int> stack(pool.acquire(11).release());
+                held[t].push(stack);
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(pool.allocated(), allocated);
+    EXPECT_EQ(pool.available(), allocated - held.size() * blockSize * 22);
+
+    for (auto& stack : held) pool.release(std::move(stack));
+    EXPECT_EQ(pool.available(), allocated);
+
+    // Acquiring everything links every chunk into one chain.
+    splicer::Stack<int> all(pool.acquire(allocated).release());
+    EXPECT_EQ(all.size(), allocated);
+    EXPECT_EQ(pool.allocated(), allocated);
+
+    std::size_t count(0);
+    for (auto node(all.head()); node; node = node->next()) ++count;
+    EXPECT_EQ(count, allocated);
+    pool.release(std::move(all));
+}
+
+TEST(ObjectPool, FullChunks)
+{
+    splicer::ObjectPool<int> pool(blockSize);
+    splicer::Stack<int> nodes(pool.acquire(blockSize * 6).release());
+    EXPECT_EQ(pool.fullChunks(), 0);
+
+    // Of releases of mixed sizes, only those of exactly one block's worth
+    // become full chunks.  The rest, including the oversized remainder, are
+    // spliced onto the loose nodes whole.
+    for (std::size_t i(0); i < 3; ++i) pool.release(nodes.popStack(blockSize));
+    pool.release(nodes.popStack(7));
+    for (std::size_t i(0); i < 3; ++i) pool.release(nodes.pop());
+    pool.release(std::move(nodes));
+
+    EXPECT_EQ(pool.fullChunks(), 3);
+    EXPECT_EQ(pool.available(), blockSize * 6);
+
+    // A multiple of the block size is served by full chunks alone.
+    splicer::Stack<int> two(pool.acquire(blockSize * 2).release());
+    EXPECT_EQ(two.size(), blockSize * 2);
+    EXPECT_EQ(pool.fullChunks(), 1);
+
+    pool.release(two.popStack(blockSize));
+    pool.release(std::move(two));
+    EXPECT_EQ(pool.fullChunks(), 3);
+
+    // Less than that is cut from the loose nodes, leaving full chunks whole.
+    splicer::Stack<int> few(pool.acquire(5).release());
+    EXPECT_EQ(few.size(), 5);
+    EXPECT_EQ(pool.fullChunks(), 3);
+    EXPECT_EQ(pool.available(), blockSize * 6 - 5);
+
+    pool.release(std::move(few));
+    EXPECT_EQ(pool.available(), blockSize * 6);
+    EXPECT_EQ(pool.allocated(), blockSize * 6);
+}
@@ -0,0 +1,171 @@
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "splice-persistent.hpp"
+#include "gtest/gtest.h"
+#include "temp-path.hpp"
+
+namespace
+{
+    struct Point
+    {
+        std::uint64_t x;
+        std::uint64_t y;
+    };
+
+    using Pool = splicer::PersistentPool<Point>;
+
+    void fill(Pool& pool)
+    {
+        Pool::UniqueStackType stack(pool.acquire(100));
+
+        std::uint64_t i(0);
+        for (Point& p : stack)
+        {
+            p.x = i;
+            p.y = i * 2;
+            ++i;
+        }
+
+        pool.store(0, std::move(stack));
+
+        // Return some nodes to the free list as well.
+        pool.release(pool.acquire(50));
+    }
+
+    void check(Pool& pool)
+    {
+        EXPECT_EQ(pool.allocated(), 256);
+        EXPECT_EQ(pool.available(), 156);
+
+        Pool::UniqueStackType stack(pool.take(0));
+        ASSERT_EQ(stack.size(), 100);
+
+        std::uint64_t i(0);
+        for (const Point& p : stack)
+        {
+            ASSERT_EQ(p.x, i);
+            ASSERT_EQ(p.y, i * 2);
+            ++i;
+        }
+
+        EXPECT_TRUE(pool.take(0).empty());
+        EXPECT_THROW(pool.take(Pool::rootCount), std::out_of_range);
+    }
+}
+
+TEST(PersistentPool, Reopen)
+{
+    const std::string path(tempPath("persistent", false));
+
+    {
+        Pool pool(path, 1000, 256);
+        EXPECT_EQ(pool.capacity(), 1024);
+        fill(pool);
+    }
+
+    {
+        Pool pool(path, 0, 256);
+        EXPECT_EQ(pool.capacity(), 1024);
+        check(pool);
+
+        // The pool is fixed-size.
+        Pool::UniqueStackType all(pool);
+        while (all.size() < pool.capacity()) all.push(pool.acquireOne());
+        EXPECT_EQ(pool.allocated(), 1024);
+        EXPECT_THROW(pool.acquireOne(), std::bad_alloc);
+    }
+
+    unlink(path.c_str());
+}
+
+TEST(PersistentPool, AcquireCapacity)
+{
+    const std::string path(tempPath("persistent", false));
+
+    {
+        Pool pool(path, 1024, 256);
+        ASSERT_EQ(pool.capacity(), 1024);
+
+        // Exactly what the pool holds, which is a multiple of the block size.
+        Pool::UniqueStackType all(pool.acquire(pool.capacity()));
+        EXPECT_EQ(all.size(), 1024);
+        EXPECT_EQ(pool.allocated(), 1024);
+        EXPECT_EQ(pool.available(), 0);
+        EXPECT_THROW(pool.acquireOne(), std::bad_alloc);
+    }
+
+    unlink(path.c_str());
+}
+
+TEST(PersistentPool, Relocate)
+{
+    const std::string path(tempPath("persistent", false));
+    const void* previous(nullptr);
+    std::size_t size(0);
+
+    {
+        Pool pool(path, 1000, 256);
+        fill(pool);
+
+        previous = pool.data();
+    }
+
+    struct stat st;
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    size = st.st_size;
+
+    // Occupy the previous address, which is unmapped again, so the file must
+    // be mapped elsewhere.
+    void* blocker(
+            mmap(
+                const_cast<void*>(previous),
+                size,
+                PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+                -1,
+                0));
+    ASSERT_NE(blocker, MAP_FAILED);
+
+    {
+        Pool pool(path, 0, 256);
+        EXPECT_TRUE(pool.relocated());
+        EXPECT_NE(pool.data(), previous);
+        check(pool);
+    }
+
+    munmap(blocker, size);
+
+    {
+        // The free list, including the nodes taken from the root above, was
+        // relinked for the address at which it was last mapped.
+        Pool pool(path, 0, 256);
+        EXPECT_EQ(pool.available(), 256);
+
+        Pool::UniqueStackType stack(pool.acquire(256));
+        EXPECT_EQ(stack.size(), 256);
+        EXPECT_EQ(pool.allocated(), 256);
+    }
+
+    unlink(path.c_str());
+}
+
+TEST(PersistentPool, InvalidFile)
+{
+    const std::string path(tempPath("persistent", false));
+
+    {
+        Pool pool(path, 256, 256);
+    }
+
+    EXPECT_THROW(
+            (splicer::PersistentPool<std::uint64_t>(path, 256, 256)),
+            std::runtime_error);
+
+    unlink(path.c_str());
+}
@@ -0,0 +1,203 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "splice-queue.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    struct Item
+    {
+        std::size_t producer;
+        std::size_t index;
+    };
+
+    using Pool = splicer::ObjectPool<Item>;
+
+    const std::size_t producers(4);
+    const std::size_t perProducer(50000);
+    const std::size_t batchSize(16);
+
+    // Each producer alternates between single nodes and batches.
+    template<typename Queue>
+    void produce(Queue& queue, Pool& pool, std::size_t producer)
+    {
+        std::size_t i(0);
+
+        while (i < perProducer)
+        {
+            if (i % 2)
+            {
+                queue.push(pool.acquireOne(Item{producer, i++}));
+            }
+            else
+            {
+                Pool::UniqueStackType stack(pool);
+                for (std::size_t j(0); j < batchSize && i < perProducer; ++j)
+                {
+                    stack.pushBack(pool.acquireOne(Item{producer, i++}));
+                }
+                queue.push(std::move(stack));
+            }
+        }
+    }
+}
+
+TEST(MpscQueue, Order)
+{
+    Pool pool(64);
+    splicer::MpscQueue<Item> queue;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+
+    for (std::size_t i(0); i < 10; ++i)
+    {
+        queue.push(pool.acquireOne(Item{0, i}));
+    }
+
+    Pool::UniqueStackType stack(pool);
+    for (std::size_t i(10); i < 20; ++i)
+    {
+        stack.pushBack(pool.acquireOne(Item{0, i}));
+    }
+    queue.push(std::move(stack));
+
+    EXPECT_FALSE(queue.empty());
+
+    Pool::UniqueStackType popped(queue.popStack(pool, 5));
+    ASSERT_EQ(popped.size(), 5);
+
+    std::size_t i(0);
+    for (const Item& item : popped) EXPECT_EQ(item.index, i++);
+
+    while (Pool::UniqueNodeType node = queue.popOne(pool))
+    {
+        EXPECT_EQ(node->index, i++);
+    }
+
+    EXPECT_EQ(i, 20);
+    EXPECT_TRUE(queue.empty());
+
+    // Queue remains usable once drained past its stub.
+    queue.push(pool.acquireOne(Item{0, 20}));
+    Pool::UniqueNodeType last(queue.popOne(pool));
+    ASSERT_FALSE(last.empty());
+    EXPECT_EQ(last->index, 20);
+
+    popped.reset();
+    last.reset();
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
+
+TEST(MpscQueue, Concurrent)
+{
+    Pool pool(4096);
+    splicer::MpscQueue<Item> queue;
+
+    std::vector<std::thread> threads;
+    for (std::size_t p(0); p < producers; ++p)
+    {
+        threads.emplace_back([&queue, &pool, p]() { produce(queue, pool, p); });
+    }
+
+    std::vector<std::size_t> next(producers, 0);
+    std::size_t received(0);
+
+    while (received < producers * perProducer)
+    {
+        Pool::UniqueNodeType node(queue.popOne(pool));
+        if (!node) continue;
+
+        // Per-producer order is preserved.
+        ASSERT_EQ(node->index, next[node->producer]++);
+        ++received;
+    }
+
+    for (auto& t : threads) t.join();
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
+
+TEST(MpmcQueue, Concurrent)
+{
+    Pool pool(4096);
+    splicer::MpmcQueue<Item> queue;
+
+    const std::size_t total(producers * perProducer);
+    std::atomic<std::size_t> received(0);
+    std::atomic<std::size_t> sum(0);
+
+    std::vector<std::thread> threads;
+    for (std::size_t p(0); p < producers; ++p)
+    {
+        threads.emplace_back([&queue, &pool, p]() { produce(queue, pool, p); });
+    }
+
+    for (std::size_t c(0); c < 4; ++c)
+    {
+        threads.emplace_back([&]()
+        {
+            while (received < total)
+            {
+                Pool::UniqueStackType stack(queue.popStack(pool, 8));
+
+                for (const Item& item : stack) sum += item.index;
+                received += stack.size();
+            }
+        });
+    }
+
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(received, total);
+    EXPECT_EQ(sum, producers * perProducer * (perProducer - 1) / 2);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
+
+TEST(MpmcQueue, Order)
+{
+    Pool pool(64);
+    splicer::MpmcQueue<Item> queue;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop());
+    EXPECT_TRUE(queue.popStack(4).empty());
+
+    for (std::size_t i(0); i < 20; ++i)
+    {
+        queue.push(pool.acquireOne(Item{0, i}));
+    }
+
+    // The rest of the batch goes back ahead of anything queued later, which
+    // a larger batch then reaches as well.
+    Pool::UniqueStackType popped(queue.popStack(pool, 5));
+    ASSERT_EQ(popped.size(), 5);
+
+    Pool::UniqueNodeType node(queue.popOne(pool));
+    ASSERT_FALSE(node.empty());
+    EXPECT_EQ(node->index, 5);
+
+    for (std::size_t i(20); i < 30; ++i)
+    {
+        queue.push(pool.acquireOne(Item{0, i}));
+    }
+
+    popped.push(queue.popStack(pool, 100));
+    ASSERT_EQ(popped.size(), 29);
+    EXPECT_TRUE(queue.empty());
+
+    std::size_t i(6);
+    for (const Item& item : popped)
+    {
+        EXPECT_EQ(item.index, i);
+        if (++i == 30) i = 0;
+    }
+
+    popped.reset();
+    node.reset();
+    EXPECT_EQ(pool.available(), pool.allocated());
+}
@@ -0,0 +1,89 @@
+#include "splice-resource.hpp"
+#include "gtest/gtest.h"
+
+#if __cplusplus >= 201703L
+
+#include <memory_resource>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+TEST(SplicePoolResource, Vector)
+{
+    splicer::SplicePoolResource resource;
+
+    {
+        std::pmr::vector<int> vec(&resource);
+        for (int i(0); i < 1000; ++i) vec.push_back(i);
+
+        for (int i(0); i < 1000; ++i) ASSERT_EQ(vec[i], i);
+    }
+
+    std::pmr::vector<std::pmr::string> strings(&resource);
+
+    for (int i(0); i < 100; ++i)
+    {
+        strings.emplace_back(std::string(i, 'a'));
+    }
+
+    for (int i(0); i < 100; ++i)
+    {
+        ASSERT_EQ(std::string(strings[i]), std::string(i, 'a'));
+    }
+}
+
+TEST(SplicePoolResource, Reuse)
+{
+    splicer::SplicePoolResource resource;
+
+    void* a(resource.allocate(100));
+    resource.deallocate(a, 100);
+
+    // Same size class, so the buffer is recycled.
+    void* b(resource.allocate(120));
+    EXPECT_EQ(a, b);
+    resource.deallocate(b, 120);
+}
+
+TEST(SplicePoolResource, Alignment)
+{
+    splicer::SplicePoolResource resource;
+    const std::size_t align(splicer::SplicePoolResource::alignment());
+    EXPECT_EQ(align, alignof(std::max_align_t));
+
+    std::vector<void*> allocations;
+
+    for (std::size_t bytes(1); bytes <= resource.maxSize(); bytes += 7)
+    {
+        void* p(resource.allocate(bytes, align));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p) % align, 0);
+        allocations.push_back(p);
+    }
+
+    std::size_t bytes(1);
+    for (void* p : allocations)
+    {
+        resource.deallocate(p, bytes, align);
+        bytes += 7;
+    }
+}
+
+TEST(SplicePoolResource, Upstream)
+{
+    splicer::SplicePoolResource resource(16, 256);
+
+    // Larger than any size class, and over-aligned, respectively.
+    void* large(resource.allocate(1024));
+    void* aligned(resource.allocate(64, 64));
+
+    EXPECT_TRUE(large);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 64, 0);
+
+    resource.deallocate(large, 1024);
+    resource.deallocate(aligned, 64, 64);
+
+    EXPECT_TRUE(resource.is_equal(resource));
+    EXPECT_FALSE(resource.is_equal(*std::pmr::new_delete_resource()));
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "splice-scheduler.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    void fib(splicer::Scheduler& scheduler, int n, std::atomic<long>& sum)
+    {
+        if (n < 2)
+        {
+            sum += n;
+            return;
+        }
+
+        splicer::Scheduler& s(scheduler);
+        s.spawn([&s, n, &sum]() { fib(s, n - 1, sum); });
+        s.spawn([&s, n, &sum]() { fib(s, n - 2, sum); });
+    }
+}
+
+TEST(Task, Storage)
+{
+    int calls(0);
+
+    splicer::Task task;
+    EXPECT_FALSE(task);
+
+    task.assign([&calls]() { ++calls; });
+    ASSERT_TRUE(static_cast<bool>(task));
+    task();
+    EXPECT_EQ(calls, 1);
+
+    // Too large to store inline.
+    std::array<int, 64> big;
+    big.fill(2);
+    task.assign([&calls, big]() { calls += big[63]; });
+    task();
+    EXPECT_EQ(calls, 3);
+
+    task.clear();
+    EXPECT_FALSE(task);
+}
+
+TEST(StealingDeque, OwnerAndThieves)
+{
+    const std::size_t count(200000);
+
+    std::vector<splicer::Node<std::size_t>> nodes(count);
+
+    // Start small, so the deque grows while thieves are stealing.
+    splicer::StealingDeque<std::size_t> deque(16);
+
+    std::atomic<std::size_t> stolen(0);
+    std::atomic<std::size_t> sum(0);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> thieves;
+    for (int i(0); i < 3; ++i)
+    {
+        thieves.emplace_back([&]()
+        {
+            while (!done || !deque.empty())
+            {
+                if (splicer::Node<std::size_t>* node = deque.steal())
+                {
+                    sum += node->val();
+                    ++stolen;
+                }
+            }
+        });
+    }
+
+    std::size_t taken(0);
+    std::size_t i(0);
+    for (splicer::Node<std::size_t>& node : nodes)
+    {
+        node.val() = i++;
+        deque.push(&node);
+
+        if (node.val() % 3 == 0)
+        {
+            if (splicer::Node<std::size_t>* node = deque.take())
+            {
+                sum += node->val();
+                ++taken;
+            }
+        }
+    }
+
+    while (splicer::Node<std::size_t>* node = deque.take())
+    {
+        sum += node->val();
+        ++taken;
+    }
+
+    done = true;
+    for (auto& t : thieves) t.join();
+
+    EXPECT_EQ(taken + stolen, count);
+    EXPECT_EQ(sum, count * (count - 1) / 2);
+}
+
+TEST(Scheduler, External)
+{
+    splicer::Scheduler scheduler(4);
+    std::atomic<std::size_t> sum(0);
+
+    const std::size_t count(100000);
+    for (std::size_t i(0); i < count; ++i)
+    {
+        scheduler.spawn([&sum, i]() { sum += i; });
+    }
+
+    scheduler.wait();
+    EXPECT_EQ(sum, count * (count - 1) / 2);
+}
+
+TEST(Scheduler, Nested)
+{
+    splicer::Scheduler scheduler(4);
+    std::atomic<long> sum(0);
+
+    scheduler.spawn([&]() { fib(scheduler, 25, sum); });
+    scheduler.wait();
+
+    EXPECT_EQ(sum, 75025);
+
+    // Over 200k tasks ran from a much smaller set of recycled nodes.
+    EXPECT_LT(scheduler.pool().allocated(), 100000);
+
+    // Reusable after waiting.
+    sum = 0;
+    scheduler.spawn([&]() { fib(scheduler, 15, sum); });
+    scheduler.wait();
+    EXPECT_EQ(sum, 610);
+}
+
+TEST(Scheduler, Exception)
+{
+    splicer::Scheduler scheduler(2);
+    std::atomic<int> ran(0);
+
+    for (int i(0); i < 100; ++i)
+    {
+        scheduler.spawn([&ran, i]()
+        {
+            ++ran;
+            if (i == 50) throw std::runtime_error("Task failed");
+        });
+    }
+
+    EXPECT_THROW(scheduler.wait(), std::runtime_error);
+    EXPECT_EQ(ran, 100);
+
+    // The error is reported once.
+    scheduler.wait();
+}
@@ -0,0 +1,187 @@
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "splice-shared.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    struct Record
+    {
+        std::uint64_t id;
+        double value;
+    };
+
+    using Pool = splicer::SharedPool<Record>;
+    using Factory = std::function<std::unique_ptr<Pool>()>;
+
+    bool readHandle(int fd, Pool::Handle& handle)
+    {
+        return read(fd, &handle, sizeof(handle)) == sizeof(handle);
+    }
+
+    bool writeHandle(int fd, const Pool::Handle& handle)
+    {
+        return write(fd, &handle, sizeof(handle)) == sizeof(handle);
+    }
+
+    // The child receives a stack from the parent and releases it, then sends
+    // a stack of its own back.  The child is forked before the pool is
+    // created, so that the base address of the pool is free in both.
+    void exchange(const Factory& factory)
+    {
+        int down[2];
+        int up[2];
+        ASSERT_EQ(pipe(down), 0);
+        ASSERT_EQ(pipe(up), 0);
+
+        const pid_t pid(fork());
+        ASSERT_GE(pid, 0);
+
+        if (!pid)
+        {
+            bool ok(true);
+
+            {
+                Pool::Handle handle;
+                ok = readHandle(down[0], handle);
+
+                std::unique_ptr<Pool> pool(factory());
+
+                {
+                    Pool::UniqueStackType stack(pool->receive(handle));
+                    ok = ok && stack.size() == 100;
+
+                    std::uint64_t i(0);
+                    for (const Record& r : stack)
+                    {
+                        ok = ok && r.id == i && r.value == i * 0.5;
+                        ++i;
+                    }
+                }
+
+                Pool::UniqueStackType stack(pool->acquire(10));
+                std::uint64_t i(0);
+                for (Record& r : stack) r.id = 1000 + i++;
+
+                ok = ok && writeHandle(up[1], pool->send(std::move(stack)));
+            }
+
+            _exit(ok ? 0 : 1);
+        }
+
+        std::unique_ptr<Pool> pool(factory());
+
+        {
+            Pool::UniqueStackType stack(pool->acquire(100));
+
+            std::uint64_t i(0);
+            for (Record& r : stack)
+            {
+                r.id = i;
+                r.value = i * 0.5;
+                ++i;
+            }
+
+            ASSERT_TRUE(writeHandle(down[1], pool->send(std::move(stack))));
+        }
+
+        EXPECT_EQ(pool->allocated(), 156);
+        EXPECT_EQ(pool->available(), 156);
+
+        Pool::Handle handle;
+        ASSERT_TRUE(readHandle(up[0], handle));
+
+        int status(0);
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+
+        // The child served its own stack from the nodes it received, and
+        // flushed the rest on exit.
+        EXPECT_EQ(pool->shared(), 90);
+
+        {
+            Pool::UniqueStackType stack(pool->receive(handle));
+            ASSERT_EQ(stack.size(), 10);
+
+            std::uint64_t i(0);
+            for (const Record& r : stack) EXPECT_EQ(r.id, 1000 + i++);
+        }
+
+        EXPECT_EQ(pool->allocated(), 166);
+        EXPECT_EQ(pool->available(), 166);
+
+        pool->flush();
+        EXPECT_EQ(pool->allocated(), 0);
+        EXPECT_EQ(pool->shared(), 256);
+
+        for (int fd : { down[0], down[1], up[0], up[1] }) close(fd);
+    }
+}
+
+TEST(SharedPool, Named)
+{
+    const std::string name("/splice-pool-test-" + std::to_string(getpid()));
+
+    exchange([&name]()
+    {
+        return std::unique_ptr<Pool>(new Pool(name, 1000, 256));
+    });
+
+    Pool::unlink(name);
+}
+
+#ifdef __linux__
+TEST(SharedPool, Memfd)
+{
+    const int fd(memfd_create("splice-pool-test", 0));
+    ASSERT_GE(fd, 0);
+
+    exchange([fd]()
+    {
+        return std::unique_ptr<Pool>(new Pool(fd, 1000, 256));
+    });
+
+    close(fd);
+}
+#endif
+
+TEST(SharedPool, Exhausted)
+{
+    const std::string name("/splice-pool-test-" + std::to_string(getpid()));
+
+    {
+        Pool pool(name, 256, 256);
+        EXPECT_EQ(pool.capacity(), 256);
+
+        Pool::UniqueStackType stack(pool.acquire(200));
+        EXPECT_THROW(pool.acquire(100), std::bad_alloc);
+    }
+
+    Pool::unlink(name);
+}
+
+TEST(SharedPool, AcquireCapacity)
+{
+    const std::string name("/splice-pool-test-" + std::to_string(getpid()));
+
+    {
+        Pool pool(name, 1024, 256);
+        ASSERT_EQ(pool.capacity(), 1024);
+
+        // The whole fixed region, a multiple of the block size, at once.
+        Pool::UniqueStackType all(pool.acquire(pool.capacity()));
+        EXPECT_EQ(all.size(), 1024);
+        EXPECT_EQ(pool.allocated(), 1024);
+        EXPECT_THROW(pool.acquireOne(), std::bad_alloc);
+    }
+
+    Pool::unlink(name);
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "splice-sorted.hpp"
+#include "gtest/gtest.h"
+
+namespace
+{
+    // A key, and an insertion sequence number.
+    using Item = std::pair<int, int>;
+
+    struct ByKey
+    {
+        bool operator()(const Item& a, const Item& b) const
+        {
+            return a.first < b.first;
+        }
+    };
+
+    using Sorted = splicer::SortedStack<Item, ByKey>;
+}
+
+TEST(SortedStack, Insert)
+{
+    Sorted::IndexPool indexPool(1024);
+    Sorted sorted(indexPool);
+
+    const int count(100000);
+    std::vector<splicer::Node<Item>> nodes(count);
+    std::vector<Item> expected;
+
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(0, 10000);
+
+    for (int i(0); i < count; ++i)
+    {
+        *nodes[i] = Item(dist(gen), i);
+        expected.push_back(*nodes[i]);
+        sorted.insert(&nodes[i]);
+    }
+
+    std::stable_sort(expected.begin(), expected.end(), ByKey());
+
+    ASSERT_EQ(sorted.size(), count);
+    EXPECT_GT(sorted.levels(), 4u);
+
+    // Equal keys retain their insertion order.
+    std::size_t i(0);
+    for (const Item& item : sorted.stack()) ASSERT_EQ(item, expected[i++]);
+    ASSERT_EQ(sorted.stack().tail()->val(), expected.back());
+
+    for (const int key : { -1, 0, 1234, 5000, 10000, 10001 })
+    {
+        const Item probe(key, 0);
+        const auto lower(
+                std::lower_bound(
+                    expected.begin(), expected.end(), probe, ByKey()));
+        const auto upper(
+                std::upper_bound(
+                    expected.begin(), expected.end(), probe, ByKey()));
+
+        splicer::Node<Item>* l(sorted.lowerBound(probe));
+        splicer::Node<Item>* u(sorted.upperBound(probe));
+
+        if (lower == expected.end()) EXPECT_FALSE(l);
+        else EXPECT_EQ(l->val(), *lower);
+
+        if (upper == expected.end()) EXPECT_FALSE(u);
+        else EXPECT_EQ(u->val(), *upper);
+
+        EXPECT_EQ(sorted.find(probe) != nullptr, lower != upper);
+    }
+
+    // The plain chain and the index are handed back.
+    splicer::Stack<Item> released(sorted.release());
+    EXPECT_EQ(released.size(), count);
+    EXPECT_TRUE(sorted.empty());
+    EXPECT_EQ(sorted.levels(), 0);
+    EXPECT_EQ(indexPool.available(), indexPool.allocated());
+}
+
+TEST(SortedStack, Erase)
+{
+    Sorted::IndexPool indexPool(1024);
+    Sorted sorted(indexPool);
+
+    const int count(20000);
+    std::vector<splicer::Node<Item>> nodes(count);
+
+    for (int i(0); i < count; ++i)
+    {
+        // Many duplicates, inserted out of order.
+        *nodes[i] = Item((i * 7919) % 500, i);
+        sorted.insert(&nodes[i]);
+    }
+
+    // Erase every other node by address, including some with equal keys.
+    for (int i(0); i < count; i += 2)
+    {
+        ASSERT_EQ(sorted.erase(&nodes[i]), &nodes[i]);
+    }
+
+    ASSERT_EQ(sorted.size(), count / 2);
+
+    std::vector<int> seen(count, 0);
+    const Item* prev(nullptr);
+    for (const Item& item : sorted.stack())
+    {
+        ASSERT_EQ(item.second % 2, 1);
+        if (prev) { ASSERT_LE(prev->first, item.first); }
+        ++seen[item.second];
+        prev = &item;
+    }
+    for (int i(1); i < count; i += 2) ASSERT_EQ(seen[i], 1);
+
+    // Erase by value, and from the front.
+    splicer::Node<Item>* front(sorted.pop());
+    ASSERT_TRUE(front);
+    EXPECT_EQ(front->val().first, 1);
+    EXPECT_LE(front->val().first, sorted.stack().head()->val().first);
+
+    const Item probe(499, 0);
+    while (sorted.erase(probe)) { }
+    EXPECT_FALSE(sorted.find(probe));
+
+    // Index entries were returned as they were erased.
+    const std::size_t size(sorted.size());
+    sorted.release();
+    EXPECT_EQ(indexPool.available(), indexPool.allocated());
+    EXPECT_LT(size, static_cast<std::size_t>(count / 2));
+}
+
+TEST(SortedStack, PushAfter)
+{
+    std::vector<splicer::Node<int>> nodes(3);
+    splicer::Stack<int> stack;
+
+    stack.pushAfter(nullptr, &nodes[1]);
+    stack.pushAfter(nullptr, &nodes[0]);
+    stack.pushAfter(&nodes[1], &nodes[2]);
+
+    EXPECT_EQ(stack.size(), 3);
+    EXPECT_EQ(stack.head(), &nodes[0]);
+    EXPECT_EQ(stack.tail(), &nodes[2]);
+    EXPECT_EQ(nodes[0].next(), &nodes[1]);
+    EXPECT_EQ(nodes[1].next(), &nodes[2]);
+}
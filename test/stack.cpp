@@ -1,4 +1,5 @@
 #include <map>
+#include <random>
 #include <stack>
 
 #include "splice-pool.hpp"
@@ -690,3 +691,339 @@ TEST(Stack, SortedStacksEmpty)
     }
 }
 
+TEST(Stack, PopAfter)
+{
+    std::vector<splicer::Node<int>> nodes(4);
+    splicer::Stack<int> stack;
+
+    for (int i(3); i >= 0; --i)
+    {
+        *nodes[i] = i;
+        stack.push(&nodes[i]);
+    }
+
+    // Middle.
+    EXPECT_EQ(stack.popAfter(&nodes[0]), &nodes[1]);
+    // Tail.
+    EXPECT_EQ(stack.popAfter(&nodes[2]), &nodes[3]);
+    EXPECT_EQ(stack.tail(), &nodes[2]);
+    // Nothing after the tail.
+    EXPECT_EQ(stack.popAfter(&nodes[2]), nullptr);
+    // Head.
+    EXPECT_EQ(stack.popAfter(nullptr), &nodes[0]);
+
+    ASSERT_EQ(stack.size(), 1);
+    EXPECT_EQ(stack.head(), &nodes[2]);
+    EXPECT_EQ(stack.tail(), &nodes[2]);
+}
+
+TEST(Stack, MergeStable)
+{
+    // Keys in the first member, origin and order in the second.
+    using Item = std::pair<int, int>;
+    const auto byKey([](const Item& a, const Item& b)
+    {
+        return a.first < b.first;
+    });
+
+    const std::size_t count(20000);
+    std::vector<splicer::Node<Item>> nodes(count * 2);
+
+    splicer::Stack<Item> a;
+    splicer::Stack<Item> b;
+
+    for (std::size_t i(0); i < count; ++i)
+    {
+        *nodes[i] = Item(i / 3, i);
+        *nodes[count + i] = Item(i / 5, count + i);
+
+        a.pushBack(&nodes[i]);
+        b.pushBack(&nodes[count + i]);
+    }
+
+    a.merge(b, byKey);
+
+    ASSERT_EQ(a.size(), count * 2);
+    ASSERT_TRUE(b.empty());
+    ASSERT_TRUE(a.sortedBy(byKey));
+    ASSERT_EQ(a.tail(), &nodes[count - 1]);
+
+    // Equal keys keep ours first, and each stack keeps its own order.
+    const Item* prev(nullptr);
+    for (const Item& item : a)
+    {
+        if (prev && prev->first == item.first)
+        {
+            ASSERT_LT(prev->second, item.second);
+        }
+        prev = &item;
+    }
+}
+
+TEST(Stack, MergeDisjoint)
+{
+    std::vector<splicer::Node<int>> nodes(makeNodes({ 1, 2, 3, 4, 5, 6 }));
+
+    {
+        splicer::Stack<int> a;
+        splicer::Stack<int> b;
+        for (std::size_t i(0); i < 3; ++i) a.pushBack(&nodes[i]);
+        for (std::size_t i(3); i < 6; ++i) b.pushBack(&nodes[i]);
+
+        a.merge(b, std::less<int>());
+        ASSERT_EQ(a.size(), 6);
+        ASSERT_EQ(a.tail(), &nodes[5]);
+
+        int i(1);
+        for (const int v : a) ASSERT_EQ(v, i++);
+    }
+
+    {
+        splicer::Stack<int> a;
+        splicer::Stack<int> b;
+        for (std::size_t i(0); i < 3; ++i) b.pushBack(&nodes[i]);
+        for (std::size_t i(3); i < 6; ++i) a.pushBack(&nodes[i]);
+
+        a.merge(b, std::less<int>());
+        ASSERT_EQ(a.size(), 6);
+        ASSERT_EQ(a.tail(), &nodes[5]);
+
+        int i(1);
+        for (const int v : a) ASSERT_EQ(v, i++);
+    }
+}
+
+TEST(Stack, PushSortedHint)
+{
+    const std::size_t count(10000);
+    std::vector<splicer::Node<int>> nodes(count);
+    std::vector<splicer::Node<int>*> order;
+
+    // Ascending, with every tenth value displaced a short way backward.
+    for (std::size_t i(0); i < count; ++i)
+    {
+        *nodes[i] = i;
+        order.push_back(&nodes[i]);
+    }
+    for (std::size_t i(10); i < count; i += 10)
+    {
+        std::swap(order[i], order[i - 3]);
+    }
+
+    splicer::Stack<int> stack;
+    stack.pushSorted(order.begin(), order.end(), std::less<int>());
+
+    ASSERT_EQ(stack.size(), count);
+    ASSERT_TRUE(stack.sortedBy(std::less<int>()));
+    EXPECT_EQ(stack.head(), &nodes.front());
+    EXPECT_EQ(stack.tail(), &nodes.back());
+
+    // Drain the sorted stack into a fresh one, which appends at the tail.
+    splicer::Stack<int> other;
+    other.pushSorted(stack, std::less<int>());
+
+    EXPECT_TRUE(stack.empty());
+    ASSERT_EQ(other.size(), count);
+
+    int i(0);
+    for (const int v : other) ASSERT_EQ(v, i++);
+
+    // Hints that compare greater than the node are ignored.
+    splicer::Node<int> a, b;
+    *a = 5;
+    *b = 5000;
+
+    splicer::Node<int>* hint(
+            other.push(other.popAfter(&nodes[4]), std::less<int>(), nullptr));
+    EXPECT_EQ(hint, &nodes[5]);
+    EXPECT_EQ(other.push(&b, std::less<int>(), hint), &b);
+    EXPECT_EQ(other.push(&a, std::less<int>(), &nodes[9000]), &a);
+
+    ASSERT_EQ(other.size(), count + 2);
+    ASSERT_TRUE(other.sortedBy(std::less<int>()));
+
+    // Following the node with an equal key.
+    EXPECT_EQ(nodes[5].next(), &a);
+    EXPECT_EQ(other.tail(), &nodes.back());
+}
+
+TEST(Stack, PushSortedStable)
+{
+    using Item = std::pair<int, int>;
+    const auto byKey([](const Item& a, const Item& b)
+    {
+        return a.first < b.first;
+    });
+
+    // Keys from 0 to 9, each repeated, in a nearly sorted order.
+    const std::size_t count(200);
+    std::vector<splicer::Node<Item>> nodes(count);
+    std::vector<Item> expected;
+
+    for (std::size_t i(0); i < count; ++i)
+    {
+        const int key((i / 20 + (i % 7 == 0 ? 9 : 0)) % 10);
+        *nodes[i] = Item(key, i);
+        expected.push_back(*nodes[i]);
+    }
+
+    std::stable_sort(expected.begin(), expected.end(), byKey);
+
+    // Without hints, with the previous insertion as the hint, with a stale
+    // hint, and in bulk.  Equal keys keep their order of insertion each way.
+    for (std::size_t mode(0); mode < 4; ++mode)
+    {
+        splicer::Stack<Item> stack;
+        splicer::Node<Item>* hint(nullptr);
+
+        if (mode == 3)
+        {
+            std::vector<splicer::Node<Item>*> order;
+            for (auto& node : nodes) order.push_back(&node);
+            stack.pushSorted(order.begin(), order.end(), byKey);
+        }
+        else
+        {
+            for (auto& node : nodes)
+            {
+                if (mode == 0) stack.push(&node, byKey);
+                else if (mode == 1) hint = stack.push(&node, byKey, hint);
+                else stack.push(&node, byKey, stack.head());
+            }
+        }
+
+        ASSERT_EQ(stack.size(), count);
+
+        std::size_t i(0);
+        for (const Item& item : stack) ASSERT_EQ(item, expected[i++]);
+        ASSERT_EQ(stack.tail()->val(), expected.back());
+    }
+}
+
+TEST(Stack, JumpIndex)
+{
+    std::vector<splicer::Node<int>> nodes(makeNodes());
+    splicer::Stack<int> stack(makeStack(nodes));
+    const splicer::Stack<int>& constStack(stack);
+
+    std::vector<int> expected;
+    for (const int v : stack) expected.push_back(v);
+
+    for (const std::size_t distance : { 0, 1, 4, 100 })
+    {
+        splicer::JumpIndex<splicer::Node<int>> index(stack.jumpIndex(distance));
+        ASSERT_EQ(index.size(), stack.size());
+
+        std::size_t i(0);
+        for (splicer::Node<int>* node(stack.head()); node; node = node->next())
+        {
+            ASSERT_EQ(index[i++], node);
+        }
+
+        std::vector<int> seen;
+        for (int& v : index) seen.push_back(v);
+        EXPECT_EQ(seen, expected);
+
+        seen.clear();
+        constStack.jumpIndex(distance).forEach([&seen](const int& v)
+        {
+            seen.push_back(v);
+        });
+        EXPECT_EQ(seen, expected);
+    }
+
+    // Values are writable through the index of a non-const Stack, which may
+    // be scanned repeatedly.
+    splicer::JumpIndex<splicer::Node<int>> index(stack.jumpIndex());
+    for (int& v : index) ++v;
+    index.forEach([](int& v) { ++v; });
+
+    std::size_t i(0);
+    for (const int v : stack) ASSERT_EQ(v, expected[i++] + 2);
+
+    splicer::Stack<int> empty;
+    EXPECT_TRUE(empty.jumpIndex().empty());
+    for (const int v : empty.jumpIndex()) { FAIL() << v; }
+}
+
+TEST(Stack, ForEachBatch)
+{
+    const std::size_t count(1000);
+    std::vector<splicer::Node<int>> nodes(count);
+    splicer::Stack<int> stack;
+
+    for (std::size_t i(0); i < count; ++i)
+    {
+        *nodes[i] = i;
+        stack.pushBack(&nodes[i]);
+    }
+
+    for (const std::size_t batch : { 0, 1, 7, 64, 1000 })
+    {
+        std::vector<int> seen;
+        stack.forEachBatch([&seen](int& v) { seen.push_back(v); }, batch);
+
+        ASSERT_EQ(seen.size(), count);
+        for (std::size_t i(0); i < count; ++i) ASSERT_EQ(seen[i], i);
+    }
+
+    int sum(0);
+    const splicer::Stack<int>& constStack(stack);
+    constStack.forEachBatch([&sum](const int& v) { sum += v; }, 4);
+    EXPECT_EQ(sum, count * (count - 1) / 2);
+
+    splicer::Stack<int> empty;
+    empty.forEachBatch([](int v) { FAIL() << v; });
+}
+
+TEST(Stack, Sort)
+{
+    using Item = std::pair<int, std::size_t>;
+    const auto byKey([](const Item& a, const Item& b)
+    {
+        return a.first < b.first;
+    });
+
+    for (const std::size_t count : { 0, 1, 2, 3, 17, 1000, 65537 })
+    {
+        std::vector<splicer::Node<Item>> nodes(count);
+        splicer::Stack<Item> stack;
+
+        std::mt19937 gen(count);
+        std::uniform_int_distribution<int> dist(0, 100);
+
+        for (std::size_t i(0); i < count; ++i)
+        {
+            *nodes[i] = Item(dist(gen), i);
+            stack.pushBack(&nodes[i]);
+        }
+
+        std::vector<Item> expected;
+        for (const Item& item : stack) expected.push_back(item);
+        std::stable_sort(expected.begin(), expected.end(), byKey);
+
+        stack.sort(byKey);
+
+        ASSERT_EQ(stack.size(), count);
+        ASSERT_TRUE(stack.sortedBy(byKey));
+
+        std::size_t i(0);
+        for (const Item& item : stack) ASSERT_EQ(item, expected[i++]);
+        if (count) { ASSERT_EQ(stack.tail()->val(), expected.back()); }
+
+        // Relink the same nodes in their original order.
+        splicer::Stack<Item> keyed;
+        for (auto& node : nodes) keyed.pushBack(&node);
+
+        keyed.sortByKey([](const Item& item) { return item.first; });
+
+        i = 0;
+        for (const Item& item : keyed) ASSERT_EQ(item, expected[i++]);
+        if (count) { ASSERT_EQ(keyed.tail()->val(), expected.back()); }
+
+        // Already sorted.
+        keyed.sort(byKey);
+        i = 0;
+        for (const Item& item : keyed) ASSERT_EQ(item, expected[i++]);
+    }
+}
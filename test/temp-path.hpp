@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+// Returns a unique path for a test file, beginning with prefix.  The file is
+// created empty, unless create is false, in which case it is removed so that
+// only the name is reserved.
+inline std::string tempPath(const std::string& prefix, bool create = true)
+{
+    std::string path("/tmp/splice-pool-" + prefix + "-XXXXXX");
+
+    const int fd(mkstemp(&path[0]));
+    if (fd >= 0) close(fd);
+    if (!create) unlink(path.c_str());
+
+    return path;
+}